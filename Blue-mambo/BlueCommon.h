@@ -35,6 +35,76 @@
  @brief Defines a UUID for this app's 2nd Bluetooth characteristic
  */
 #define CHARACTERISTICUUID2 @"b72e"
+/**
+ @def ACKWINDOWSIZE
+ @brief Defines the number of notifications that may be in flight before an acknowledgement is required (at most 32)
+ */
+#define ACKWINDOWSIZE 16
+/**
+ @def ACKINTERVAL
+ @brief Defines how long the listener may hold acknowledgements before writing them back
+ */
+#define ACKINTERVAL 0.05
+/**
+ @def RETRANSMITTIMEOUT
+ @brief Defines how long the broadcaster waits for an acknowledgement before resending a notification
+ */
+#define RETRANSMITTIMEOUT 0.5
+/**
+ @def DGKBBlueDropFrames
+ @brief Set this to TRUE to simulate a lossy link: each side discards a share of the notifications it sends or receives
+ */
+#define DGKBBlueDropFrames FALSE
+/**
+ @def DGKBBlueDropPercentage
+ @brief Defines the percentage of notifications each side discards when DGKBBlueDropFrames is TRUE
+ */
+#define DGKBBlueDropPercentage 10
+/**
+ @def FANOUTQUANTUM
+ @brief Defines how many bytes each subscribed central may be sent per scheduling round
+ */
+#define FANOUTQUANTUM 64
+/**
+ @def FANOUTBACKLOG
+ @brief Defines how many notifications may be queued for one central before the oldest are discarded
+ */
+#define FANOUTBACKLOG 256
+/**
+ @def LAGREPORTINTERVAL
+ @brief Defines how often a debug build logs a summary of each subscribed central's lag metrics
+ */
+#define LAGREPORTINTERVAL 5.0
+/**
+ @def SAMPLECODEC
+ @brief Set this to TRUE to batch samples using the delta/varint codec, FALSE to send one raw sample per notification
+ */
+#define SAMPLECODEC TRUE
+/**
+ @def SAMPLEFRAMELENGTH
+ @brief Defines the largest encoded sample frame; a 20 byte notification less the 2 byte sequence number
+ */
+#define SAMPLEFRAMELENGTH 18
+/**
+ @def SAMPLEKEYFRAMEINTERVAL
+ @brief Defines how often (in frames) the sample codec sends a keyframe so a listener can resynchronise
+ */
+#define SAMPLEKEYFRAMEINTERVAL 8
+/**
+ @def SAMPLEFLUSHINTERVAL
+ @brief Defines how long a partly filled sample frame may wait for more samples
+ */
+#define SAMPLEFLUSHINTERVAL 0.1
+/**
+ @def SAMPLEGENERATOR
+ @brief Set this to TRUE to send synthetic samples (a random walk) while any central is subscribed; there is no real sample source yet, so this is for exercising the codec and the link only
+ */
+#define SAMPLEGENERATOR FALSE
+/**
+ @def SAMPLEGENERATORINTERVAL
+ @brief Defines how often the synthetic sample generator produces a sample
+ */
+#define SAMPLEGENERATORINTERVAL 0.02
 
 #endif
 
@@ -8,6 +8,11 @@
 
 #import <Foundation/Foundation.h>
 
+@class DGKBEventRecorder;
+@class DGKBPipelineTrace;
+@class DGKBScanScheduler;
+@class DGKBProcessingQueue;
+
 /**
  @addtogroup Types
  @{
@@ -82,6 +87,59 @@ typedef void(^DGKBBluetoothCharacteristicChangeBlockType)(CBCharacteristic *char
 
 /** @} */
 
+/**
+ @protocol DGKBCentralManager
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Central manager
+
+ The parts of CBCentralManager that the scanner uses. CBCentralManager conforms to this, and so
+ does DGKBEventReplayer, which lets the scanner be driven from a recorded event trace.
+ */
+@protocol DGKBCentralManager <NSObject>
+
+/// The manager's current state
+@property (readonly) CBCentralManagerState state;
+
+/**
+ @brief Set the object that receives central manager events
+ @param delegate The delegate
+ */
+- (void)setDelegate:(id<CBCentralManagerDelegate>)delegate;
+
+/**
+ @brief Start scanning for peripherals
+ @param serviceUUIDs The services to scan for, or nil for all
+ @param options Scanning options
+ */
+- (void)scanForPeripheralsWithServices:(NSArray *)serviceUUIDs
+                               options:(NSDictionary *)options;
+
+/**
+ @brief Stop scanning for peripherals
+ */
+- (void)stopScan;
+
+/**
+ @brief Connect a peripheral
+ @param peripheral The peripheral
+ @param options Connection options
+ */
+- (void)connectPeripheral:(CBPeripheral *)peripheral
+                  options:(NSDictionary *)options;
+
+/**
+ @brief Cancel a peripheral connection
+ @param peripheral The peripheral
+ */
+- (void)cancelPeripheralConnection:(CBPeripheral *)peripheral;
+
+@end
+
+/** @} */
+
 /**
  @interface DGKBBluetoothScanner
  @addtogroup Classes
@@ -90,7 +148,10 @@ typedef void(^DGKBBluetoothCharacteristicChangeBlockType)(CBCharacteristic *char
 /**
  @brief Bluetooth Scanner
  
- Functionality to scan for Bluetooth services, connect peripherals and get peripheral characteristics
+ Functionality to scan for Bluetooth services, connect peripherals and get peripheral characteristics.
+ All of the scanner's work happens on its processing queue; its methods can be called from any thread.
+ Create one scanner and keep it: its central manager, and the queue that manager delivers on, live
+ exactly as long as it does.
  @see DGKBBluetoothScanner()
  */
 @interface DGKBBluetoothScanner : NSObject <CBCentralManagerDelegate, CBPeripheralDelegate>
@@ -98,10 +159,45 @@ typedef void(^DGKBBluetoothCharacteristicChangeBlockType)(CBCharacteristic *char
 /// The Core Bluetooth manager's current state
 @property (readonly) CBCentralManagerState state;
 
+/// The queue that Core Bluetooth events, and so every code block given to the scanner, are delivered on
+@property (nonatomic, readonly) DGKBProcessingQueue *processingQueue;
+
+/// Records every event the scanner receives, if set
+@property (nonatomic, strong) DGKBEventRecorder *recorder;
+
+/// Timestamps the pipeline stages the scanner sees, if set
+@property (nonatomic, strong) DGKBPipelineTrace *pipelineTrace;
+
+/// Duty cycles scanning, if set; otherwise the scanner scans continuously until it times out.
+/// Each new scan starts from the scheduler's normal pause, and only time spent scanning counts towards the timeout.
+@property (nonatomic, strong) DGKBScanScheduler *scanScheduler;
+
+/// The number of discovery callbacks received
+@property (nonatomic, readonly) NSUInteger discoveryCount;
+
+/// Divides every timeout, scan window and scan pause the scanner times (1 unless set), so a session replayed faster than real time keeps its timing @see DGKBEventReplayer
+@property (nonatomic, assign) double timeScale;
+
+/**
+ @brief Initialise a scanner with a Core Bluetooth central manager
+ @return The scanner
+ */
+- (id)init;
+
+/**
+ @brief Initialise a scanner with another central manager
+ 
+ Used to replay recorded events through the scanner @see DGKBEventReplayer
+ 
+ @param centralManager The central manager
+ @return The scanner
+ */
+- (id)initWithCentralManager:(id<DGKBCentralManager>)centralManager;
+
 /**
  @brief Start scanning for peripherals
  
- @param seconds The number of seconds before timeout
+ @param seconds The number of seconds of scanning before timeout; pauses between scan windows do not count
  @param foundBlock The block to execute if a peripheral is found
  @param timeoutBlock The block to execute if no peripherals are found
  */
@@ -109,6 +205,21 @@ typedef void(^DGKBBluetoothCharacteristicChangeBlockType)(CBCharacteristic *char
                onFoundPeripheral:(DGKBBluetoothScanSuccessBlockType)foundBlock
                       onTimedOut:(DGKBBluetoothScanTimeoutBlockType)timeoutBlock;
 
+/**
+ @brief Start scanning for peripherals advertising particular services
+ 
+ Only adverts for the given services reach the found block, and each peripheral is reported once per scan window
+ 
+ @param serviceUUIDs The services to scan for, or nil for all peripherals
+ @param seconds The number of seconds of scanning before timeout; pauses between scan windows do not count
+ @param foundBlock The block to execute if a peripheral is found
+ @param timeoutBlock The block to execute if no peripherals are found
+ */
+- (void)startScanningForServices:(NSArray *)serviceUUIDs
+                     withTimeout:(NSTimeInterval)seconds
+               onFoundPeripheral:(DGKBBluetoothScanSuccessBlockType)foundBlock
+                      onTimedOut:(DGKBBluetoothScanTimeoutBlockType)timeoutBlock;
+
 /**
  @brief Stop scanning for peripherals 
  */
@@ -7,6 +7,20 @@
 //
 
 #import "DGKBBluetoothScanner.h"
+#import "DGKBEventRecorder.h"
+#import "DGKBPipelineTrace.h"
+#import "DGKBScanScheduler.h"
+#import "DGKBProcessingQueue.h"
+#import "DGKBQueueTimer.h"
+
+/**
+ @brief CBCentralManager already implements everything DGKBCentralManager needs
+ */
+@interface CBCentralManager (DGKBCentralManager) <DGKBCentralManager>
+@end
+
+@implementation CBCentralManager (DGKBCentralManager)
+@end
 
 /**
  @extends DGKBBluetoothScanner
@@ -20,8 +34,12 @@
  */
 @interface DGKBBluetoothScanner ()
 
-@property (nonatomic, strong) CBCentralManager *centralManager; ///< The central Bluetooth manager
-@property (nonatomic) NSTimeInterval scanTimeout; ///< The scan timeout period
+@property (nonatomic, strong) id<DGKBCentralManager> centralManager; ///< The central Bluetooth manager
+@property (nonatomic) NSTimeInterval scanTimeout; ///< The scan timeout period, counted in time spent scanning
+@property (nonatomic) NSTimeInterval scanTimeRemaining; ///< The scanning left before the timeout, already scaled by the time scale
+@property (nonatomic) NSTimeInterval scanWindowOpenedAt; ///< When the current scan window opened, as system uptime
+@property (nonatomic, strong) NSArray *scanServiceUUIDs; ///< The services to scan for, or nil for all
+@property (nonatomic, assign) BOOL foundInScanWindow; ///< Has anything been found in the current scan window?
 @property (nonatomic, copy) DGKBBluetoothScanSuccessBlockType scanBlock; ///< The code block for scan success
 @property (nonatomic, copy) DGKBBluetoothScanTimeoutBlockType scanTimeoutBlock; ///< The code block for scan timeout
 @property (nonatomic, assign) BOOL scanWhenReady; ///< Will scanning be deferred until the core Bluetooth is alive?
@@ -36,19 +54,80 @@
 @property (nonatomic, copy) DGKBBluetoothCharacteristicsSuccessBlockType characteristicsBlock; ///< The code block for successful characteristic retrieval
 @property (nonatomic, copy) DGKBBluetoothCharacteristicChangeBlockType changeBlock; ///< The code block for characteristic value change
 @property (nonatomic) NSTimeInterval requestTimeout; ///< The request timeout period
+@property (nonatomic, strong) DGKBQueueTimer *scanningTimer; ///< Times scanning out
+@property (nonatomic, strong) DGKBQueueTimer *dutyCycleTimer; ///< Opens and closes scan windows
+@property (nonatomic, strong) DGKBQueueTimer *connectionTimer; ///< Times the connection out
+@property (nonatomic, strong) DGKBQueueTimer *requestTimer; ///< Times the request out
+
+/**
+ @brief Create the processing queue and the timers that run on it
+ */
+- (void)createProcessingQueue;
+
+/**
+ @brief Scale a delay by the time scale
+ @param seconds The delay in real time
+ @return The delay to time
+ */
+- (NSTimeInterval)scaledDelay:(NSTimeInterval)seconds;
 
 /**
  @brief Starts scanning
  
- - Start the scanning timeout monitor
- - Scan for peripherals
+ - Clear any deferred scan, since this is it starting
+ - Forget the scan scheduler's misses from earlier scans
+ - Allow the whole scan timeout
+ - Open the first scan window
  */
 - (void)startScanning;
+/**
+ @brief Scan for peripherals until the window closes
+ 
+ - Scan for the requested services, reporting each peripheral once per window
+ - Start the scanning timeout monitor for the scanning time that is left
+ - If there is a scan scheduler, start the scan window monitor
+ */
+- (void)openScanWindow;
+/**
+ @brief Start scan window monitor
+ 
+ - Cancel any currently running duty cycle monitor
+ - Set up a timer that will call scanWindowDidClose when the scheduler says the window ends
+ */
+- (void)startScanWindowMonitor;
+/**
+ @brief Start scan pause monitor
+ 
+ - Cancel any currently running duty cycle monitor
+ - Set up a timer that will call scanPauseDidElapse when the scheduler says the pause ends
+ */
+- (void)startScanPauseMonitor;
+/**
+ @brief Cancel the duty cycle monitors
+ 
+ - Cancel the timer that opens and closes scan windows
+ */
+- (void)cancelDutyCycleMonitor;
+/**
+ @brief Handle the end of a scan window
+ 
+ - Stop scanning, and stop the scanning timeout monitor while the radio is idle
+ - Take the time the window was open off the scanning time that is left, timing out if none is
+ - Tell the scheduler if nothing was found, so that it backs off
+ - Start the scan pause monitor
+ */
+- (void)scanWindowDidClose;
+/**
+ @brief Handle the end of a scan pause
+ 
+ - Open the next scan window
+ */
+- (void)scanPauseDidElapse;
 /**
  @brief Start scanning timeout monitor
 
  - Cancel any currently running scanning timeout monitor
- - Set up a timer that will call scanningDidTimeout after the specified period
+ - Set up a timer that will call scanningDidTimeout when the scanning time that is left runs out
  */
 - (void)startScanningTimeoutMonitor;
 /**
@@ -139,11 +218,54 @@
     self = [super init];
     if (self)
     {
-        _centralManager = [[CBCentralManager alloc] initWithDelegate:self queue:nil];
+        [self createProcessingQueue];
+        _centralManager = [[CBCentralManager alloc] initWithDelegate:self queue:_processingQueue.queue];
     }
     return self;
 }
 
+- (id)initWithCentralManager:(id<DGKBCentralManager>)centralManager
+{
+    self = [super init];
+    if (self)
+    {
+        [self createProcessingQueue];
+        _centralManager = centralManager;
+        [_centralManager setDelegate:self];
+    }
+    return self;
+}
+
+/**
+ - Core Bluetooth does not zero its delegate references, so detach from the central manager and
+   the current peripheral on the queue their events arrive on
+ - Once that has run, no callback is still in progress and none can follow
+ */
+- (void)dealloc
+{
+    id<DGKBCentralManager> centralManager = _centralManager;
+    CBPeripheral *peripheral = _currentPeripheral;
+    [_processingQueue sync:^{
+        [centralManager setDelegate:nil];
+        peripheral.delegate = nil;
+    }];
+}
+
+- (void)createProcessingQueue
+{
+    _processingQueue = [[DGKBProcessingQueue alloc] initWithLabel:@"com.dgkb.blue-mambo.scanner"];
+    _scanningTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _dutyCycleTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _connectionTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _requestTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _timeScale = 1.0;
+}
+
+- (NSTimeInterval)scaledDelay:(NSTimeInterval)seconds
+{
+    return _timeScale > 0 ? seconds / _timeScale : seconds;
+}
+
 - (CBCentralManagerState)state
 {
     return _centralManager.state;
@@ -153,6 +275,7 @@
  When a peripheral is found, execute the supplied code block.
  If no peripherals are found within the timeout period, execute the timeout code block
  
+ - Move onto the processing queue
  - Save the parameters to instance properties.
  - If the central manager is not powered on, defer scanning until it is.
  - Otherwise start scanning
@@ -161,57 +284,134 @@
                onFoundPeripheral:(DGKBBluetoothScanSuccessBlockType)foundBlock
                       onTimedOut:(DGKBBluetoothScanTimeoutBlockType)timeoutBlock
 {
-    DEBUGLog(@"Starting scan (%1.1f)...", seconds);
-    _scanTimeout = seconds;
-    _scanBlock = foundBlock;
-    _scanTimeoutBlock = timeoutBlock;
-    if (_centralManager.state != CBCentralManagerStatePoweredOn)
-    {
-        // Defer scanning until manager comes online.
-        _scanWhenReady = YES;
-        return;
-    }
-    [self startScanning];
+    [self startScanningForServices:nil
+                       withTimeout:seconds
+                 onFoundPeripheral:foundBlock
+                        onTimedOut:timeoutBlock];
+}
+
+- (void)startScanningForServices:(NSArray *)serviceUUIDs
+                     withTimeout:(NSTimeInterval)seconds
+               onFoundPeripheral:(DGKBBluetoothScanSuccessBlockType)foundBlock
+                      onTimedOut:(DGKBBluetoothScanTimeoutBlockType)timeoutBlock
+{
+    [_processingQueue async:^{
+        DEBUGLog(@"Starting scan (%1.1f)...", seconds);
+        _scanServiceUUIDs = serviceUUIDs;
+        _scanTimeout = seconds;
+        _scanBlock = foundBlock;
+        _scanTimeoutBlock = timeoutBlock;
+        if (_centralManager.state != CBCentralManagerStatePoweredOn)
+        {
+            // Defer scanning until manager comes online.
+            _scanWhenReady = YES;
+            return;
+        }
+        [self startScanning];
+    }];
 }
 
 - (void)startScanning
 {
+    _scanWhenReady = NO;
     _scanState = YES;  // scanning
+    [_pipelineTrace markStage:DGKBPipelineScanStart];
     
+    [_scanScheduler reset];
+    _scanTimeRemaining = [self scaledDelay:_scanTimeout];
+    [self openScanWindow];
+}
+
+- (void)openScanWindow
+{
+    _foundInScanWindow = NO;
+    _scanWindowOpenedAt = [[NSProcessInfo processInfo] systemUptime];
+    [_centralManager scanForPeripheralsWithServices:_scanServiceUUIDs
+                                            options:@{CBCentralManagerScanOptionAllowDuplicatesKey : @NO}];
     [self startScanningTimeoutMonitor];
-    
-    [_centralManager scanForPeripheralsWithServices:nil
-                                            options:nil];
+    [self startScanWindowMonitor];
+}
+
+- (void)startScanWindowMonitor
+{
+    [self cancelDutyCycleMonitor];
+    NSTimeInterval window = [_scanScheduler scanWindow];
+    if (!_scanScheduler || window < 0) return;
+    __weak DGKBBluetoothScanner *weakSelf = self;
+    [_dutyCycleTimer startWithDelay:[self scaledDelay:window]
+                              block:^{
+                                  [weakSelf scanWindowDidClose];
+                              }];
+}
+
+- (void)startScanPauseMonitor
+{
+    __weak DGKBBluetoothScanner *weakSelf = self;
+    [_dutyCycleTimer startWithDelay:[self scaledDelay:[_scanScheduler nextPause]]
+                              block:^{
+                                  [weakSelf scanPauseDidElapse];
+                              }];
+}
+
+- (void)cancelDutyCycleMonitor
+{
+    [_dutyCycleTimer cancel];
+}
+
+- (void)scanWindowDidClose
+{
+    [_centralManager stopScan];
+    [self cancelScanningTimeoutMonitor];
+    _scanTimeRemaining -= [[NSProcessInfo processInfo] systemUptime] - _scanWindowOpenedAt;
+    if (_scanTimeRemaining <= 0)
+    {
+        [self scanningDidTimeout];
+        return;
+    }
+    if (!_foundInScanWindow) [_scanScheduler didMiss];
+    DEBUGLog(@"Scan window closed (%ld discoveries, %ld misses)", _discoveryCount, _scanScheduler.consecutiveMisses);
+    [self startScanPauseMonitor];
+}
+
+- (void)scanPauseDidElapse
+{
+    [self openScanWindow];
 }
 
 /**
  The code blocks supplied when scanning started will not be called
  when the scan is stopped through a call to this method
  
+ - Move onto the processing queue
+ - Forget any scan deferred until Bluetooth is ready, so a later power cycle does not start it
  - Cancel the scanning timout monitor.
+ - Cancel the duty cycle monitors
  - Stop scanning
  */
 - (void)stopScanning
 {
-    DEBUGLog(@"Stopping scan...");
-    [self cancelScanningTimeoutMonitor];
-    [_centralManager stopScan];
-    _scanState = NO;
+    [_processingQueue async:^{
+        DEBUGLog(@"Stopping scan (%ld discoveries)...", _discoveryCount);
+        _scanWhenReady = NO;
+        [self cancelScanningTimeoutMonitor];
+        [self cancelDutyCycleMonitor];
+        [_centralManager stopScan];
+        _scanState = NO;
+    }];
 }
 
 - (void)startScanningTimeoutMonitor
 {
-    [self cancelScanningTimeoutMonitor];
-    [self performSelector:@selector(scanningDidTimeout)
-               withObject:nil
-               afterDelay:_scanTimeout];
+    __weak DGKBBluetoothScanner *weakSelf = self;
+    [_scanningTimer startWithDelay:_scanTimeRemaining
+                             block:^{
+                                 [weakSelf scanningDidTimeout];
+                             }];
 }
 
 - (void)cancelScanningTimeoutMonitor
 {
-    [NSObject cancelPreviousPerformRequestsWithTarget:self
-                                             selector:@selector(scanningDidTimeout)
-                                               object:nil];
+    [_scanningTimer cancel];
 }
 
 - (void)scanningDidTimeout
@@ -230,6 +430,7 @@
  If connection is successful, execute the connectBlock code block. When the connection
  is broken, execute the disconnectBlock code block
  
+ - Move onto the processing queue
  - Save the parameters to instance properties.
  - Connect to the peripheral
  - Start a connection timeout monitor
@@ -240,20 +441,23 @@
              onDisconnect:(DGKBBluetoothDisconnectSuccessBlockType)disconnectBlock
                onTimedOut:(DGKBBluetoothConnectTimeoutBlockType)timeoutBlock
 {
-    DEBUGLog(@"Starting connection...");
-    
-    _connectTimeout = seconds;
-    _connectBlock = connectBlock;
-    _disconnectBlock = disconnectBlock;
-    _connectTimeoutBlock = timeoutBlock;
-    
-    [_centralManager connectPeripheral:peripheral
-                               options:nil];
-    
-    /// @note If you don't retain the CBPeripheral during the connection,
-    ///       this request will silently fail. The call to startConnectionTimeoutMonitor
-    ///       will retain the peripheral for timeout purposes.
-    [self startConnectionTimeoutMonitor:peripheral];
+    [_processingQueue async:^{
+        DEBUGLog(@"Starting connection...");
+        
+        _connectTimeout = seconds;
+        _connectBlock = connectBlock;
+        _disconnectBlock = disconnectBlock;
+        _connectTimeoutBlock = timeoutBlock;
+        
+        [_pipelineTrace markStage:DGKBPipelineConnectRequested];
+        [_centralManager connectPeripheral:peripheral
+                                   options:nil];
+        
+        /// @note If you don't retain the CBPeripheral during the connection,
+        ///       this request will silently fail. The call to startConnectionTimeoutMonitor
+        ///       will retain the peripheral for timeout purposes.
+        [self startConnectionTimeoutMonitor:peripheral];
+    }];
 }
 
 /**
@@ -261,28 +465,35 @@
  provided when the connection had been made will be executed
  
  - If no peripheral is provided, do nothing
- - Otherwise cancel the peripheral connection
+ - Otherwise cancel the peripheral connection, on the processing queue
  */
 - (void)disconnect:(CBPeripheral *)peripheral
 {
     DEBUGLog(@"Disconnecting ...");
     if (!peripheral) return;
-    [_centralManager cancelPeripheralConnection:peripheral];
+    [_processingQueue async:^{
+        [_centralManager cancelPeripheralConnection:peripheral];
+    }];
 }
 
+/**
+ - The timer's block holds the peripheral until the timer fires
+ */
 - (void)startConnectionTimeoutMonitor:(CBPeripheral *)peripheral
 {
-    [self cancelConnectionTimeoutMonitor:peripheral];
-    [self performSelector:@selector(connectionDidTimeout:)
-               withObject:peripheral
-               afterDelay:_connectTimeout];
+    __weak DGKBBluetoothScanner *weakSelf = self;
+    [_connectionTimer startWithDelay:[self scaledDelay:_connectTimeout]
+                               block:^{
+                                   [weakSelf connectionDidTimeout:peripheral];
+                               }];
 }
 
+/**
+ - Only one connection is monitored at a time, so the peripheral is not needed
+ */
 - (void)cancelConnectionTimeoutMonitor:(CBPeripheral *)peripheral
 {
-    [NSObject cancelPreviousPerformRequestsWithTarget:self
-                                             selector:@selector(connectionDidTimeout:)
-                                               object:peripheral];
+    [_connectionTimer cancel];
 }
 
 - (void)connectionDidTimeout:(CBPeripheral *)peripheral
@@ -298,6 +509,7 @@
 /**
  Discover the services offered by a peripheral. A list of services to search for is provided
  
+ - Move onto the processing queue
  - Save the parameters to instance properties
  - Set the peripheral's delegate to self
  - Discover peripheral services
@@ -306,17 +518,20 @@
                withUUIDs:(NSArray *)serviceUUIDs
          onFoundServices:(DGKBBluetoothDiscoverSuccessBlockType)block
 {
-    DEBUGLog(@"Start discovering...");
-    _discoverBlock = block;
-    _currentPeripheral = peripheral;
-    peripheral.delegate = self;
-    [peripheral discoverServices:serviceUUIDs];
+    [_processingQueue async:^{
+        DEBUGLog(@"Start discovering...");
+        _discoverBlock = block;
+        _currentPeripheral = peripheral;
+        peripheral.delegate = self;
+        [peripheral discoverServices:serviceUUIDs];
+    }];
 }
 
 /**
  Discover the characteristics of a service offered by the peripheral. A list of characteristics
  to search for is provided
 
+ - Move onto the processing queue
  - Save the parameters to instance properties
  - Discover characteristics for the current peripheral
  */
@@ -326,25 +541,29 @@
     onFoundCharacteristics:(DGKBBluetoothCharacteristicsSuccessBlockType)foundBlock
    onChangedCharacteristic:(DGKBBluetoothCharacteristicChangeBlockType)changeBlock
 {
-    _characteristicsBlock = foundBlock;
-    _changeBlock = changeBlock;
-    [_currentPeripheral discoverCharacteristics:characteristicUUIDs
-                                     forService:service];
+    [_processingQueue async:^{
+        _characteristicsBlock = foundBlock;
+        _changeBlock = changeBlock;
+        [_currentPeripheral discoverCharacteristics:characteristicUUIDs
+                                         forService:service];
+    }];
 }
 
 - (void)startRequestTimeoutMonitor:(CBCharacteristic *)characteristic
 {
-    [self cancelRequestTimeoutMonitor:characteristic];
-    [self performSelector:@selector(requestDidTimeout:)
-               withObject:characteristic
-               afterDelay:_requestTimeout];
+    __weak DGKBBluetoothScanner *weakSelf = self;
+    [_requestTimer startWithDelay:[self scaledDelay:_requestTimeout]
+                            block:^{
+                                [weakSelf requestDidTimeout:characteristic];
+                            }];
 }
 
+/**
+ - Only one request is monitored at a time, so the characteristic is not needed
+ */
 - (void)cancelRequestTimeoutMonitor:(CBCharacteristic *)characteristic
 {
-    [NSObject cancelPreviousPerformRequestsWithTarget:self
-                                             selector:@selector(requestDidTimeout:)
-                                               object:characteristic];
+    [_requestTimer cancel];
 }
 
 - (void)requestDidTimeout:(CBCharacteristic *)characteristic
@@ -398,6 +617,7 @@
     NSString *description = [self getCBCentralStateName:central.state];
 
     DEBUGLog(@"%@ (%@)", description, central);
+    [_recorder recordState:central.state];
     switch (central.state)
     {
         case CBCentralManagerStatePoweredOn:
@@ -418,6 +638,12 @@
                   RSSI:(NSNumber *)RSSI
 {    
     DEBUGLog(@"Name: %@", peripheral.name);
+    _discoveryCount++;
+    _foundInScanWindow = YES;
+    [_scanScheduler didFind];
+    [_recorder recordDiscoveredPeripheral:peripheral
+                        advertisementData:advertisementData
+                                     RSSI:RSSI];
     
     _scanBlock (peripheral, advertisementData, RSSI);
 }
@@ -426,6 +652,8 @@
   didConnectPeripheral:(CBPeripheral *)peripheral
 {
     DEBUGLog(@"%@", peripheral.name);
+    [_recorder recordConnectedPeripheral:peripheral];
+    [_pipelineTrace markStage:DGKBPipelineConnected];
     [self cancelConnectionTimeoutMonitor:peripheral];
     _connectBlock();
 }
@@ -435,6 +663,7 @@ didFailToConnectPeripheral:(CBPeripheral *)peripheral
                  error:(NSError *)error
 {
     DEBUGLog(@"%@", peripheral);
+    [_recorder recordFailedToConnectPeripheral:peripheral];
     [self cancelConnectionTimeoutMonitor:peripheral];
     //    [self.delegate centralClient:self connectDidFail:error];
 }
@@ -444,6 +673,7 @@ didDisconnectPeripheral:(CBPeripheral *)peripheral
                  error:(NSError *)error
 {
     DEBUGLog(@"%@", peripheral);
+    [_recorder recordDisconnectedPeripheral:peripheral];
     _disconnectBlock();
 }
 
@@ -460,6 +690,8 @@ didDiscoverServices:(NSError *)error
         return;
     }
     DEBUGLog(@"Discovered");
+    [_recorder recordServicesOfPeripheral:peripheral];
+    [_pipelineTrace markStage:DGKBPipelineServicesFound];
     _discoverBlock(peripheral);
 }
 
@@ -480,6 +712,9 @@ didDiscoverCharacteristicsForService:(CBService *)service
         DEBUGLog(@"Error: %@", error);
         return;
     }
+    [_recorder recordCharacteristicsOfService:service
+                                   peripheral:peripheral];
+    [_pipelineTrace markStage:DGKBPipelineCharacteristicsFound];
     _characteristicsBlock(service);
 }
 
@@ -502,9 +737,25 @@ didUpdateValueForCharacteristic:(CBCharacteristic *)characteristic
         //        [self.delegate centralClient:self requestForCharacteristic:characteristic didFail:error];
         return;
     }
+    [_recorder recordValueOfCharacteristic:characteristic
+                                peripheral:peripheral];
+    [_pipelineTrace markStage:DGKBPipelineFirstValue];
     _changeBlock (characteristic);
 }
 
+- (void)peripheral:(CBPeripheral *)peripheral
+didUpdateNotificationStateForCharacteristic:(CBCharacteristic *)characteristic
+             error:(NSError *)error
+{
+    DEBUGLog(@"%@ Notifying: %d", characteristic.UUID, characteristic.isNotifying);
+    if (error)
+    {
+        DEBUGLog(@"Error: %@", error);
+        return;
+    }
+    if (characteristic.isNotifying) [_pipelineTrace markStage:DGKBPipelineNotifyEnabled];
+}
+
 - (void)peripheral:(CBPeripheral *)peripheral
 didUpdateValueForDescriptor:(CBDescriptor *)descriptor
              error:(NSError *)error
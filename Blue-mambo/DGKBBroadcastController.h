@@ -36,6 +36,22 @@
  */
 - (IBAction)didPressDisconnectButton:(id)sender;
 
+/**
+	@brief Get lag metrics for each subscribed central
+	@return An array of dictionaries, one per central @see DGKBFanoutScheduler
+ */
+- (NSArray *)subscriberLagMetrics;
+
+/**
+	@brief Send a sample to the subscribed centrals
+	
+	Samples are batched several to a notification unless SAMPLECODEC is FALSE. Can be called from any thread.
+	If SAMPLEGENERATOR is TRUE the controller also sends itself synthetic samples while any central is subscribed.
+	
+	@param sample The sample
+ */
+- (void)sendSample:(int32_t)sample;
+
 @end
 
 /** @} */
\ No newline at end of file
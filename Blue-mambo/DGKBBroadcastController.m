@@ -8,6 +8,12 @@
 
 #import "DGKBBroadcastController.h"
 #import "BlueCommon.h"
+#import "DGKBFanoutScheduler.h"
+#import "DGKBSampleCodec.h"
+#import "DGKBProcessingQueue.h"
+#import "DGKBQueueTimer.h"
+#import "DGKBViewSnapshot.h"
+#import "DGKBSnapshotChannel.h"
 
 /**
  @extends DGKBBroadcastController
@@ -32,24 +38,74 @@
 @property (nonatomic, strong) CBUUID *serviceUUID;                      ///< The peripheral's service UUID
 @property (nonatomic, strong) CBUUID *characteristicUUID;               ///< The peripheral's service's characteristic UUID
 
+@property (nonatomic, strong) DGKBProcessingQueue *processingQueue;    ///< The queue the peripheral manager and everything it drives runs on
 @property (nonatomic, strong) CBPeripheralManager *peripheralManager;   ///< The peripheral manager
 @property (nonatomic, assign) BOOL serviceRequiresRegistration;         ///< Does the service require registration?
+@property (nonatomic, assign) BOOL advertiseWhenReady;                  ///< Should the service be advertised when Bluetooth is ready?
 @property (nonatomic, strong) CBMutableService *service;                ///< The service
 @property (nonatomic, strong) CBMutableCharacteristic *characteristic1; ///< The 1st characteristic
 @property (nonatomic, strong) CBMutableCharacteristic *characteristic2; ///< The 2nd characteristic
 
-@property (nonatomic, strong) NSData *pendingData;                      ///< Data that is waiting to be sent
+@property (nonatomic, strong) DGKBFanoutScheduler *fanout;              ///< Subscribed centrals and their unsent or unacknowledged notifications
+@property (nonatomic, strong) DGKBSampleCodec *sampleCodec;             ///< Batches samples into notifications
+@property (nonatomic, strong) DGKBQueueTimer *retransmitTimer;          ///< Fires when the oldest unacknowledged frame is due
+@property (nonatomic, strong) DGKBQueueTimer *sampleFlushTimer;         ///< Fires when a partly filled sample frame should be sent
+@property (nonatomic, strong) DGKBQueueTimer *lagReportTimer;           ///< Fires when the lag metrics summary is due
+@property (nonatomic, strong) DGKBQueueTimer *sampleGeneratorTimer;     ///< Fires when the next synthetic sample is due
+@property (nonatomic, assign) int32_t generatedSample;                  ///< The last synthetic sample
+@property (nonatomic, assign) NSUInteger sampleCount;                   ///< The number of samples sent
+@property (nonatomic, assign) NSUInteger sampleByteCount;               ///< The number of bytes the samples were sent in
+
+@property (nonatomic, strong) DGKBMutableViewSnapshot *viewModel;       ///< What the screen should show, kept on the processing queue
+@property (nonatomic, strong) DGKBSnapshotChannel *snapshotChannel;     ///< Hands view model snapshots to the main thread
+@property (nonatomic, strong) DGKBViewSnapshot *appliedSnapshot;        ///< The snapshot the screen is showing
 
 /**
  @brief Show the Bluetooth status
  @param message Message to display
  @param colour Colour to display the message
  
- - Display the message in the centralManagerStatus label
+ - Put the message in the view model and publish it
  */
 - (void)showStatus:(NSString *)message
          andColour:(UIColor *)colour;
 
+/**
+ @brief Publish a snapshot of the view model to the main thread
+ */
+- (void)publishViewModel;
+
+/**
+ @brief Show a view model snapshot; runs on the main thread
+ @param snapshot The snapshot
+ 
+ - Update the labels and the disconnect button
+ - Pulse the screen once for any connections or disconnections since the last snapshot
+ */
+- (void)applySnapshot:(DGKBViewSnapshot *)snapshot;
+
+/**
+ @brief Pulse the screen; runs on the main thread
+ @param colour The colour to pulse
+ */
+- (void)pulseColour:(UIColor *)colour;
+
+/**
+ @brief A central subscribed
+ 
+ - Ask the screen to pulse green
+ - Show the disconnect button
+ */
+- (void)centralDidConnect;
+
+/**
+ @brief A central unsubscribed
+ 
+ - Ask the screen to pulse red
+ - Hide the disconnect button
+ */
+- (void)centralDidDisconnect;
+
 /**
  @brief Get a description for a peripheral manager's state
  @param state A peripheral manager state
@@ -59,6 +115,104 @@
  */
 - (NSString *)getCBPeripheralStateName:(CBPeripheralManagerState) state;
 
+/**
+ @brief Send as many frames to the subscribed centrals as the peripheral manager will accept
+ 
+ - Let the fan-out scheduler share the send opportunity between the centrals
+ - Send each frame to its own central only, or discard it if DGKBBlueDropFrames is simulating loss
+ - If the transmit queue filled up, wait for peripheralManagerIsReadyToUpdateSubscribers: rather than
+   the retransmit timer, which would otherwise fire straight away for an overdue frame and spin
+ - Otherwise restart the retransmit timeout monitor
+ */
+- (void)pumpSendWindow;
+/**
+ @brief Start retransmit timeout monitor
+ 
+ - Cancel any currently running retransmit timeout monitor
+ - Set up a timer that will call retransmitDidTimeout when the oldest unacknowledged frame is due
+ */
+- (void)startRetransmitTimeoutMonitor;
+/**
+ @brief Cancel the retransmit timeout monitor
+ 
+ - Remove the timer that was set up to monitor acknowledgements
+ */
+- (void)cancelRetransmitTimeoutMonitor;
+/**
+ @brief Handle retransmit timeout
+ 
+ - Resend any frames that have not been acknowledged
+ */
+- (void)retransmitDidTimeout;
+/**
+ @brief Start lag report monitor
+ 
+ - Do nothing unless this is a debug build, or if the monitor is already running
+ - Set up a timer that will call lagReportDidTimeout after LAGREPORTINTERVAL
+ */
+- (void)startLagReportMonitor;
+/**
+ @brief Cancel the lag report monitor
+ 
+ - Remove the timer that was set up to report lag metrics
+ */
+- (void)cancelLagReportMonitor;
+/**
+ @brief Handle lag report timeout
+ 
+ - Log the lag metrics summary
+ - Start the monitor again while any central is subscribed
+ */
+- (void)lagReportDidTimeout;
+/**
+ @brief Log one line of lag metrics for each subscribed central
+ */
+- (void)logLagSummary;
+/**
+ @brief Start sample generator monitor
+ 
+ - Do nothing unless SAMPLEGENERATOR is TRUE, or if the monitor is already running
+ - Set up a timer that will call sampleGeneratorDidTimeout after SAMPLEGENERATORINTERVAL
+ */
+- (void)startSampleGeneratorMonitor;
+/**
+ @brief Cancel the sample generator monitor
+ 
+ - Remove the timer that was set up to generate samples
+ */
+- (void)cancelSampleGeneratorMonitor;
+/**
+ @brief Handle sample generator timeout
+ 
+ - Take a random step from the last synthetic sample and send it
+ - Start the monitor again while any central is subscribed
+ */
+- (void)sampleGeneratorDidTimeout;
+/**
+ @brief Queue a sample frame for the subscribed centrals
+ @param frame The frame
+ */
+- (void)sendSampleFrame:(NSData *)frame;
+/**
+ @brief Start sample flush monitor
+ 
+ - Do nothing if the monitor is already running, so a trickle of samples cannot hold a frame back indefinitely
+ - Set up a timer that will call sampleFlushDidTimeout
+ */
+- (void)startSampleFlushMonitor;
+/**
+ @brief Cancel the sample flush monitor
+ 
+ - Remove the timer that was set up to flush the current sample frame
+ */
+- (void)cancelSampleFlushMonitor;
+/**
+ @brief Handle sample flush timeout
+ 
+ - Send the partly filled sample frame
+ */
+- (void)sampleFlushDidTimeout;
+
 @end
 
 /** @} */
@@ -70,26 +224,85 @@
  */
 @implementation DGKBBroadcastController
 
-- (void)viewDidAppear:(BOOL)animated
+/**
+ - Create the processing queue and the peripheral manager once for the life of the screen
+ - Create the timers, the schedulers, the view model and the snapshot channel, which all work with the processing queue
+ */
+- (void)viewDidLoad
 {
-    [super viewDidAppear:animated];
+    [super viewDidLoad];
+    
+    _processingQueue = [[DGKBProcessingQueue alloc] initWithLabel:@"com.dgkb.blue-mambo.broadcast"];
+    _retransmitTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _sampleFlushTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _lagReportTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _sampleGeneratorTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+    _viewModel = [[DGKBMutableViewSnapshot alloc] init];
+    __weak DGKBBroadcastController *weakSelf = self;
+    _snapshotChannel = [[DGKBSnapshotChannel alloc] initWithConsumer:^(id snapshot)
+                                                                     {
+                                                                         [weakSelf applySnapshot:snapshot];
+                                                                     }];
     
     _serviceName = SERVICENAME;
     _serviceUUID = [CBUUID UUIDWithString:SERVICEUUID];
 //    _characteristicUUID = [CBUUID UUIDWithString:CHARACTERISTICUUID];
     
-    // Initialize peripheral manager providing self as its delegate
-    _peripheralManager = [[CBPeripheralManager alloc] initWithDelegate:self queue:nil];
+    _fanout = [[DGKBFanoutScheduler alloc] initWithWindowSize:ACKWINDOWSIZE
+                                            retransmitTimeout:RETRANSMITTIMEOUT
+                                                      quantum:FANOUTQUANTUM
+                                                 backlogLimit:FANOUTBACKLOG];
+    _sampleCodec = [[DGKBSampleCodec alloc] initWithFrameLength:SAMPLEFRAMELENGTH
+                                               keyframeInterval:SAMPLEKEYFRAMEINTERVAL];
+
+    // Initialize peripheral manager providing self as its delegate; its events arrive on the processing queue
+    _peripheralManager = [[CBPeripheralManager alloc] initWithDelegate:self queue:_processingQueue.queue];
 }
 
+/**
+ - Advertise the service now if Bluetooth is ready, otherwise as soon as it is
+ */
+- (void)viewDidAppear:(BOOL)animated
+{
+    [super viewDidAppear:animated];
+    
+    [_processingQueue sync:^{
+        _advertiseWhenReady = YES;
+        if (_peripheralManager.state == CBPeripheralManagerStatePoweredOn && !_service) [self enableService];
+    }];
+}
+
+/**
+ - Take the service down, which stops advertising
+ - Forget the subscribed centrals and stop everything that was timing them
+ */
 - (void)viewDidDisappear:(BOOL)animated
 {
-    [self stopAdvertising];
-    _peripheralManager = nil;
+    [_processingQueue sync:^{
+        _advertiseWhenReady = NO;
+        [self disableService];
+        [self cancelRetransmitTimeoutMonitor];
+        [self cancelSampleFlushMonitor];
+        [self cancelLagReportMonitor];
+        [self cancelSampleGeneratorMonitor];
+        [_fanout removeAllCentrals];
+    }];
     
     [super viewDidDisappear:animated];
 }
 
+/**
+ - Core Bluetooth does not zero its delegate reference, so detach from the peripheral manager on
+   the queue its events arrive on; once that has run, no callback is in progress and none can follow
+ */
+- (void)dealloc
+{
+    CBPeripheralManager *peripheralManager = _peripheralManager;
+    [_processingQueue sync:^{
+        peripheralManager.delegate = nil;
+    }];
+}
+
 - (void)didReceiveMemoryWarning
 {
     [super didReceiveMemoryWarning];
@@ -116,13 +329,16 @@
     // no default value set.
     //
     // There is no need to set the permission on characteristic.
-    // Assign the characteristic.
+    // Assign the characteristic. The 2nd characteristic carries acknowledgements
+    // back from the central. It only allows writes without response, since
+    // acknowledgements are never answered; a write with response is refused
+    // rather than left waiting for a reply that would never come.
     _characteristic1 = [[CBMutableCharacteristic alloc] initWithType:[CBUUID UUIDWithString:CHARACTERISTICUUID1]
                                                           properties:CBCharacteristicPropertyNotify
                                                                value:nil
                                                          permissions:0];
     _characteristic2 = [[CBMutableCharacteristic alloc] initWithType:[CBUUID UUIDWithString:CHARACTERISTICUUID2]
-                                                          properties:CBCharacteristicPropertyWrite
+                                                          properties:CBCharacteristicPropertyWriteWithoutResponse
                                                                value:nil
                                                          permissions:CBAttributePermissionsWriteable];
     _service.characteristics = @[_characteristic1,
@@ -134,7 +350,7 @@
 
 - (void)disableService
 {
-    [_peripheralManager removeService:_service];
+    if (_service) [_peripheralManager removeService:_service];
     _service = nil;
     [self stopAdvertising];
 }
@@ -172,8 +388,47 @@
 - (void)showStatus:(NSString *)message
          andColour:(UIColor *)colour
 {
-    _peripheralManagerStatus.text = message;
-    _peripheralManagerStatus.textColor = colour;
+    _viewModel.statusText = message;
+    _viewModel.statusColour = colour;
+    [self publishViewModel];
+}
+
+- (void)publishViewModel
+{
+    [_snapshotChannel publish:[_viewModel copy]];
+}
+
+- (void)applySnapshot:(DGKBViewSnapshot *)snapshot
+{
+    if (snapshot.statusText)
+    {
+        _peripheralManagerStatus.text = snapshot.statusText;
+        _peripheralManagerStatus.textColor = snapshot.statusColour;
+    }
+    if (snapshot.bluetoothStatus)
+    {
+        _hostBluetoothStatus.text = snapshot.bluetoothStatus;
+        _hostBluetoothStatus.textColor = [UIColor whiteColor];
+    }
+    if (snapshot.logText != _appliedSnapshot.logText) _reportLog.text = snapshot.logText;
+    _disconnectButton.hidden = !snapshot.connected;
+    if (snapshot.connectPulseCount != _appliedSnapshot.connectPulseCount) [self pulseColour:[UIColor greenColor]];
+    if (snapshot.disconnectPulseCount != _appliedSnapshot.disconnectPulseCount) [self pulseColour:[UIColor redColor]];
+    _appliedSnapshot = snapshot;
+}
+
+- (void)pulseColour:(UIColor *)colour
+{
+    [UIView animateWithDuration:0.1
+                     animations:^{
+                         self.view.backgroundColor = colour;
+                     }
+                     completion:^(BOOL finished) {
+                         [UIView animateWithDuration:0.1
+                                          animations:^{
+                                              self.view.backgroundColor = SCREENCOLOUR;
+                                          }];
+                     }];
 }
 
 // Converts CBPeripheralManagerState to a string
@@ -214,69 +469,216 @@
 }
 
 - (void)sendToSubscribers:(NSData *)data
+{
+    [_fanout enqueuePayload:data];
+    [self pumpSendWindow];
+}
+
+- (void)pumpSendWindow
 {
     if (_peripheralManager.state != CBPeripheralManagerStatePoweredOn)
     {
-        DEBUGLog(@"sendToSubscribers: peripheral not ready for sending state: %ld", _peripheralManager.state);
+        DEBUGLog(@"pumpSendWindow: peripheral not ready for sending state: %ld", _peripheralManager.state);
         return;
     }
     
-    BOOL success = [_peripheralManager updateValue:data
-                                 forCharacteristic:self.characteristic1
-                              onSubscribedCentrals:nil];
-    if (!success)
+    BOOL queueFull = [_fanout serviceWithBlock:^BOOL(NSData *frame, CBCentral *central)
+                                               {
+#if (DGKBBlueDropFrames == TRUE)
+                                                   if (arc4random_uniform(100) < DGKBBlueDropPercentage)
+                                                   {
+                                                       // Report the frame as sent, so its window waits for an acknowledgement that never comes.
+                                                       DEBUGLog(@"Dropped %ld bytes", [frame length]);
+                                                       return YES;
+                                                   }
+#endif
+                                                   BOOL success = [_peripheralManager updateValue:frame
+                                                                                forCharacteristic:_characteristic1
+                                                                             onSubscribedCentrals:@[central]];
+                                                   if (!success)
+                                                   {
+                                                       // The frame stays in the central's window and is offered again once the manager is ready.
+                                                       DEBUGLog(@"Transmit queue full, waiting until ready.");
+                                                       return NO;
+                                                   }
+                                                   DEBUGLog(@"Sent %ld bytes", [frame length]);
+                                                   return YES;
+                                               }];
+    if (queueFull)
     {
-        DEBUGLog(@"Failed to send data, buffering data for retry once ready.");
-        _pendingData = data;
+        [self cancelRetransmitTimeoutMonitor];
         return;
     }
-    DEBUGLog(@"Sent %ld bytes", [data length]);
+    [self startRetransmitTimeoutMonitor];
 }
 
-- (void)centralDidConnect
+- (void)startRetransmitTimeoutMonitor
 {
-    // Pulse the screen blue.
-    [UIView animateWithDuration:0.1
-                     animations:^{
-                         self.view.backgroundColor = [UIColor greenColor];
-                     }
-                     completion:^(BOOL finished) {
-                         [UIView animateWithDuration:0.1
-                                          animations:^{
-                                              self.view.backgroundColor = SCREENCOLOUR;
-                                          }];
-                         [self showStatus:@"Connected"
-                                andColour:[UIColor greenColor]];
-                         _disconnectButton.hidden = NO;
+    [self cancelRetransmitTimeoutMonitor];
+    NSTimeInterval delay = [_fanout timeUntilNextRetransmit];
+    if (delay < 0) return;
+    __weak DGKBBroadcastController *weakSelf = self;
+    [_retransmitTimer startWithDelay:delay
+                               block:^{
+                                   [weakSelf retransmitDidTimeout];
+                               }];
+}
 
-                     }];
+- (void)cancelRetransmitTimeoutMonitor
+{
+    [_retransmitTimer cancel];
 }
 
-- (void)centralDidDisconnect {
-    // Pulse the screen red.
-    [UIView animateWithDuration:0.1
-                     animations:^{
-                         self.view.backgroundColor = [UIColor redColor];
-                     }
-                     completion:^(BOOL finished) {
-                         [UIView animateWithDuration:0.1
-                                          animations:^{
-                                              self.view.backgroundColor = SCREENCOLOUR;
-                                          }];
-                         [self showStatus:@"Advertising"
-                                andColour:[UIColor greenColor]];
-                         _disconnectButton.hidden = YES;
+- (void)retransmitDidTimeout
+{
+    [self pumpSendWindow];
+}
 
-                     }];
+- (void)startLagReportMonitor
+{
+#ifdef DEBUG
+    if (_lagReportTimer.isScheduled) return;
+    __weak DGKBBroadcastController *weakSelf = self;
+    [_lagReportTimer startWithDelay:LAGREPORTINTERVAL
+                              block:^{
+                                  [weakSelf lagReportDidTimeout];
+                              }];
+#endif
+}
+
+- (void)cancelLagReportMonitor
+{
+    [_lagReportTimer cancel];
+}
+
+- (void)lagReportDidTimeout
+{
+    [self logLagSummary];
+    if (_fanout.centralCount > 0) [self startLagReportMonitor];
+}
+
+- (void)logLagSummary
+{
+    for (NSDictionary *metrics in [_fanout lagMetrics])
+    {
+        DEBUGLog(@"%@: sent %@ (%@ bytes, %.0f B/s, %.0f%% share) acked %@ resent %@ dropped %@ queued %@ in flight %@ ack age %.2fs",
+                 metrics[DGKBFanoutCentralKey],
+                 metrics[DGKBFanoutSentKey],
+                 metrics[DGKBFanoutSentBytesKey],
+                 [metrics[DGKBFanoutThroughputKey] doubleValue],
+                 [metrics[DGKBFanoutShareKey] doubleValue] * 100.0,
+                 metrics[DGKBFanoutAcknowledgedKey],
+                 metrics[DGKBFanoutRetransmittedKey],
+                 metrics[DGKBFanoutDroppedKey],
+                 metrics[DGKBFanoutQueuedKey],
+                 metrics[DGKBFanoutInFlightKey],
+                 [metrics[DGKBFanoutAckAgeKey] doubleValue]);
+    }
+}
+
+- (void)sendSample:(int32_t)sample
+{
+    [_processingQueue async:^{
+#if (SAMPLECODEC == TRUE)
+        NSData *frame = [_sampleCodec addSample:sample];
+        if (frame)
+        {
+            [self cancelSampleFlushMonitor];
+            [self sendSampleFrame:frame];
+        }
+        [self startSampleFlushMonitor];
+#else
+        [self sendSampleFrame:[DGKBSampleCodec rawFrameForSample:sample]];
+#endif
+        _sampleCount++;
+    }];
+}
+
+- (void)startSampleGeneratorMonitor
+{
+#if (SAMPLEGENERATOR == TRUE)
+    if (_sampleGeneratorTimer.isScheduled) return;
+    __weak DGKBBroadcastController *weakSelf = self;
+    [_sampleGeneratorTimer startWithDelay:SAMPLEGENERATORINTERVAL
+                                    block:^{
+                                        [weakSelf sampleGeneratorDidTimeout];
+                                    }];
+#endif
+}
+
+- (void)cancelSampleGeneratorMonitor
+{
+    [_sampleGeneratorTimer cancel];
+}
+
+- (void)sampleGeneratorDidTimeout
+{
+    _generatedSample += (int32_t)arc4random_uniform(21) - 10;
+    [self sendSample:_generatedSample];
+    if (_fanout.centralCount > 0) [self startSampleGeneratorMonitor];
+}
+
+- (void)sendSampleFrame:(NSData *)frame
+{
+    _sampleByteCount += frame.length;
+    [self sendToSubscribers:frame];
+}
+
+- (void)startSampleFlushMonitor
+{
+    if (_sampleFlushTimer.isScheduled) return;
+    __weak DGKBBroadcastController *weakSelf = self;
+    [_sampleFlushTimer startWithDelay:SAMPLEFLUSHINTERVAL
+                                block:^{
+                                    [weakSelf sampleFlushDidTimeout];
+                                }];
+}
+
+- (void)cancelSampleFlushMonitor
+{
+    [_sampleFlushTimer cancel];
+}
+
+- (void)sampleFlushDidTimeout
+{
+    NSData *frame = [_sampleCodec flush];
+    if (frame) [self sendSampleFrame:frame];
+}
+
+- (void)centralDidConnect
+{
+    [_viewModel pulseConnect];
+    _viewModel.connected = YES;
+    [self showStatus:@"Connected"
+           andColour:[UIColor greenColor]];
+}
+
+- (void)centralDidDisconnect
+{
+    [_viewModel pulseDisconnect];
+    _viewModel.connected = NO;
+    [self showStatus:@"Advertising"
+           andColour:[UIColor greenColor]];
+}
+
+- (NSArray *)subscriberLagMetrics
+{
+    __block NSArray *metrics;
+    [_processingQueue sync:^{
+        metrics = [_fanout lagMetrics];
+    }];
+    return metrics;
 }
 
 #pragma mark - UI Action handlers
 
 - (void)didPressDisconnectButton:(id)sender
 {
-    if (_peripheralManager.isAdvertising) {
-        [_peripheralManager stopAdvertising];
-    }
+    [_processingQueue async:^{
+        if (_peripheralManager.isAdvertising) {
+            [_peripheralManager stopAdvertising];
+        }
+    }];
 }
 
 #pragma mark - CBPeripheralManagerDelegate delegate implementation
@@ -284,12 +686,12 @@
 - (void)peripheralManagerDidUpdateState:(CBPeripheralManager *)peripheral
 {
     DEBUGLog(@"%@", peripheral);
-    _hostBluetoothStatus.text = [self getCBPeripheralStateName:peripheral.state];
-    _hostBluetoothStatus.textColor = [UIColor whiteColor];
+    _viewModel.bluetoothStatus = [self getCBPeripheralStateName:peripheral.state];
+    [self publishViewModel];
     
     switch (peripheral.state) {
         case CBPeripheralManagerStatePoweredOn:
-            [self enableService];
+            if (_advertiseWhenReady) [self enableService];
             break;
         
         case CBPeripheralManagerStatePoweredOff:
@@ -338,7 +740,13 @@ didSubscribeToCharacteristic:(CBCharacteristic *)characteristic {
     DEBUGLog(@"%@", characteristic.UUID);
     DEBUGLog(@"Central: %@", central.UUID);
     [self centralDidConnect];
-    [self sendToSubscribers:[@"Hello" dataUsingEncoding:NSUTF8StringEncoding]];
+    [_fanout addCentral:central];
+    [_sampleCodec requestKeyframe];
+    [_fanout enqueuePayload:[@"Hello" dataUsingEncoding:NSUTF8StringEncoding]
+                  toCentral:central];
+    [self pumpSendWindow];
+    [self startLagReportMonitor];
+    [self startSampleGeneratorMonitor];
     
 }
 
@@ -346,16 +754,21 @@ didSubscribeToCharacteristic:(CBCharacteristic *)characteristic {
                   central:(CBCentral *)central
 didUnsubscribeFromCharacteristic:(CBCharacteristic *)characteristic {
     DEBUGLog(@"%@", central.UUID);
+    [self logLagSummary];
+    DEBUGLog(@"Samples: %ld in %ld bytes", _sampleCount, _sampleByteCount);
+    [_fanout removeCentral:central];
+    if (_fanout.centralCount == 0)
+    {
+        [self cancelRetransmitTimeoutMonitor];
+        [self cancelLagReportMonitor];
+        [self cancelSampleGeneratorMonitor];
+    }
     [self centralDidDisconnect];
 }
 
 - (void)peripheralManagerIsReadyToUpdateSubscribers:(CBPeripheralManager *)peripheral {
     DEBUGLog(@"");
-    if (_pendingData) {
-        NSData *data = [_pendingData copy];
-        _pendingData = nil;
-        [self sendToSubscribers:data];
-    }
+    [self pumpSendWindow];
 }
 
 - (void)peripheralManagerDidStartAdvertising:(CBPeripheralManager *)peripheral
@@ -370,7 +783,15 @@ didUnsubscribeFromCharacteristic:(CBCharacteristic *)characteristic {
 - (void)peripheralManager:(CBPeripheralManager *)peripheral
   didReceiveWriteRequests:(NSArray *)requests
 {
-    DEBUGLog(@"");
+    DEBUGLog(@"%ld request(s)", requests.count);
+    // The ack characteristic only allows writes without response, so there is nothing to respond to.
+    for (CBATTRequest *request in requests) {
+        if ([request.characteristic.UUID isEqual:_characteristic2.UUID]) {
+            [_fanout processAck:request.value
+                    fromCentral:request.central];
+        }
+    }
+    [self pumpSendWindow];
 }
 
 - (void)peripheralManager:(CBPeripheralManager *)peripheral
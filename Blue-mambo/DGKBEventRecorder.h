@@ -0,0 +1,139 @@
+//
+//  DGKBEventRecorder.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @addtogroup Types
+ @{
+ */
+
+/**
+ @def DGKBTraceMagic
+ @brief The 4 bytes that start every event trace
+ */
+#define DGKBTraceMagic "DGKT"
+/**
+ @def DGKBTraceVersion
+ @brief The event trace format version
+ */
+#define DGKBTraceVersion 1
+
+/**
+ @typedef DGKBTraceEventType
+ @brief Event trace record types
+
+ Every record starts with its type (1 byte) and the microseconds since the previous record
+ (varint). Strings, UUIDs and data are a varint length followed by the bytes. Peripherals are
+ referred to by a varint index that is defined by a DGKBTraceEventPeripheral record the first
+ time the peripheral object is seen. The UUID in the definition is the one the peripheral had
+ then (all zero if it had none); a peripheral that gains a UUID later keeps its index.
+ */
+typedef enum
+{
+    DGKBTraceEventState = 1,            ///< state (1 byte)
+    DGKBTraceEventPeripheral,           ///< index, UUID (16 bytes), name
+    DGKBTraceEventDiscover,             ///< index, RSSI (1 byte, signed), local name, service UUID count, service UUIDs
+    DGKBTraceEventConnect,              ///< index
+    DGKBTraceEventFailToConnect,        ///< index
+    DGKBTraceEventDisconnect,           ///< index
+    DGKBTraceEventServices,             ///< index, service UUID count, service UUIDs
+    DGKBTraceEventCharacteristics,      ///< index, service UUID, characteristic count, (characteristic UUID, properties (1 byte)) each
+    DGKBTraceEventValue                 ///< index, service UUID, characteristic UUID, value
+} DGKBTraceEventType;
+
+/** @} */
+
+/**
+ @interface DGKBEventRecorder
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Core Bluetooth event recorder
+
+ Records the central manager and peripheral events that DGKBBluetoothScanner receives into a
+ compact binary trace, which DGKBEventReplayer can play back later. Error callbacks are not
+ recorded, and only the advertisement data the listener looks at (local name and service UUIDs)
+ is kept.
+ @see DGKBEventReplayer
+ */
+@interface DGKBEventRecorder : NSObject
+
+/// The trace recorded so far
+@property (nonatomic, readonly) NSData *trace;
+
+/// The number of events recorded so far, not counting peripheral definitions
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/**
+ @brief Record a central manager state change
+ @param state The new state
+ */
+- (void)recordState:(CBCentralManagerState)state;
+
+/**
+ @brief Record a discovered peripheral
+ @param peripheral The peripheral
+ @param advertisementData The advertisement data for the peripheral
+ @param RSSI The RSSI
+ */
+- (void)recordDiscoveredPeripheral:(CBPeripheral *)peripheral
+                 advertisementData:(NSDictionary *)advertisementData
+                              RSSI:(NSNumber *)RSSI;
+
+/**
+ @brief Record a peripheral connecting
+ @param peripheral The peripheral
+ */
+- (void)recordConnectedPeripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Record a peripheral failing to connect
+ @param peripheral The peripheral
+ */
+- (void)recordFailedToConnectPeripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Record a peripheral disconnecting
+ @param peripheral The peripheral
+ */
+- (void)recordDisconnectedPeripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Record the services discovered for a peripheral
+ @param peripheral The peripheral
+ */
+- (void)recordServicesOfPeripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Record the characteristics discovered for a service
+ @param service The service
+ @param peripheral The service's peripheral
+ */
+- (void)recordCharacteristicsOfService:(CBService *)service
+                            peripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Record a characteristic's new value
+ @param characteristic The characteristic
+ @param peripheral The characteristic's peripheral
+ */
+- (void)recordValueOfCharacteristic:(CBCharacteristic *)characteristic
+                         peripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Write the trace to a file
+ @param path The file path
+ @return YES if the trace was written
+ */
+- (BOOL)writeToFile:(NSString *)path;
+
+@end
+
+/** @} */
@@ -0,0 +1,267 @@
+//
+//  DGKBEventRecorder.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBEventRecorder.h"
+
+/**
+ @extends DGKBEventRecorder
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Core Bluetooth event recorder extension
+
+ Internal functionality for the event recorder. Private extensions to DGKBEventRecorder @see DGKBEventRecorder
+ */
+@interface DGKBEventRecorder ()
+
+@property (nonatomic, strong) NSMutableData *buffer;            ///< The trace being recorded
+@property (nonatomic, strong) NSMapTable *peripherals;          ///< Peripheral indexes keyed by peripheral object identity
+@property (nonatomic, assign) NSTimeInterval lastEventTime;     ///< When the previous event was recorded
+
+/**
+ @brief Start a record
+ @param type The record type
+
+ - Write the record type
+ - Write the microseconds since the previous record
+ */
+- (void)beginRecord:(DGKBTraceEventType)type;
+
+/**
+ @brief Start an event record
+ @param type The record type
+
+ - Start the record
+ - Count the event
+ */
+- (void)beginEvent:(DGKBTraceEventType)type;
+
+/**
+ @brief Get the index of a peripheral, defining it first if it has not been seen before
+ @param peripheral The peripheral
+ @return The peripheral's index
+ */
+- (NSUInteger)indexOfPeripheral:(CBPeripheral *)peripheral;
+
+/**
+ @brief Append an unsigned LEB128 varint
+ @param value The value
+ */
+- (void)appendVarint:(uint64_t)value;
+
+/**
+ @brief Append a length prefixed block of bytes
+ @param data The bytes
+ */
+- (void)appendData:(NSData *)data;
+
+/**
+ @brief Append a length prefixed UTF-8 string
+ @param string The string (nil is written as an empty string)
+ */
+- (void)appendString:(NSString *)string;
+
+/**
+ @brief Append a length prefixed Bluetooth UUID
+ @param UUID The UUID
+ */
+- (void)appendUUID:(CBUUID *)UUID;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBEventRecorder
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBEventRecorder
+
+- (id)init
+{
+    self = [super init];
+    if (self)
+    {
+        _buffer = [NSMutableData dataWithBytes:DGKBTraceMagic length:4];
+        uint8_t version = DGKBTraceVersion;
+        [_buffer appendBytes:&version length:1];
+        // Peripherals are held for the recording's lifetime, so no other peripheral can reuse one's address.
+        _peripherals = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                             valueOptions:NSPointerFunctionsStrongMemory];
+        _lastEventTime = [[NSProcessInfo processInfo] systemUptime];
+    }
+    return self;
+}
+
+- (NSData *)trace
+{
+    return [_buffer copy];
+}
+
+- (void)recordState:(CBCentralManagerState)state
+{
+    [self beginEvent:DGKBTraceEventState];
+    uint8_t value = (uint8_t)state;
+    [_buffer appendBytes:&value length:1];
+}
+
+- (void)recordDiscoveredPeripheral:(CBPeripheral *)peripheral
+                 advertisementData:(NSDictionary *)advertisementData
+                              RSSI:(NSNumber *)RSSI
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    NSArray *serviceUUIDs = advertisementData[CBAdvertisementDataServiceUUIDsKey];
+
+    [self beginEvent:DGKBTraceEventDiscover];
+    [self appendVarint:index];
+    int8_t rssi = (int8_t)MAX(-128, MIN(127, RSSI.integerValue));
+    [_buffer appendBytes:&rssi length:1];
+    [self appendString:advertisementData[CBAdvertisementDataLocalNameKey]];
+    [self appendVarint:serviceUUIDs.count];
+    for (CBUUID *UUID in serviceUUIDs)
+    {
+        [self appendUUID:UUID];
+    }
+}
+
+- (void)recordConnectedPeripheral:(CBPeripheral *)peripheral
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    [self beginEvent:DGKBTraceEventConnect];
+    [self appendVarint:index];
+}
+
+- (void)recordFailedToConnectPeripheral:(CBPeripheral *)peripheral
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    [self beginEvent:DGKBTraceEventFailToConnect];
+    [self appendVarint:index];
+}
+
+- (void)recordDisconnectedPeripheral:(CBPeripheral *)peripheral
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    [self beginEvent:DGKBTraceEventDisconnect];
+    [self appendVarint:index];
+}
+
+- (void)recordServicesOfPeripheral:(CBPeripheral *)peripheral
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    [self beginEvent:DGKBTraceEventServices];
+    [self appendVarint:index];
+    [self appendVarint:peripheral.services.count];
+    for (CBService *service in peripheral.services)
+    {
+        [self appendUUID:service.UUID];
+    }
+}
+
+- (void)recordCharacteristicsOfService:(CBService *)service
+                            peripheral:(CBPeripheral *)peripheral
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    [self beginEvent:DGKBTraceEventCharacteristics];
+    [self appendVarint:index];
+    [self appendUUID:service.UUID];
+    [self appendVarint:service.characteristics.count];
+    for (CBCharacteristic *characteristic in service.characteristics)
+    {
+        [self appendUUID:characteristic.UUID];
+        uint8_t properties = (uint8_t)characteristic.properties;
+        [_buffer appendBytes:&properties length:1];
+    }
+}
+
+- (void)recordValueOfCharacteristic:(CBCharacteristic *)characteristic
+                         peripheral:(CBPeripheral *)peripheral
+{
+    NSUInteger index = [self indexOfPeripheral:peripheral];
+    [self beginEvent:DGKBTraceEventValue];
+    [self appendVarint:index];
+    [self appendUUID:characteristic.service.UUID];
+    [self appendUUID:characteristic.UUID];
+    [self appendData:characteristic.value];
+}
+
+- (BOOL)writeToFile:(NSString *)path
+{
+    return [_buffer writeToFile:path atomically:YES];
+}
+
+- (void)beginRecord:(DGKBTraceEventType)type
+{
+    NSTimeInterval now = [[NSProcessInfo processInfo] systemUptime];
+    uint8_t value = (uint8_t)type;
+    [_buffer appendBytes:&value length:1];
+    [self appendVarint:(uint64_t)MAX(0, (now - _lastEventTime) * 1000000.0)];
+    _lastEventTime = now;
+}
+
+- (void)beginEvent:(DGKBTraceEventType)type
+{
+    [self beginRecord:type];
+    _eventCount++;
+}
+
+/**
+ - Peripherals are told apart by object identity, not UUID: a peripheral that has never connected
+   may have no UUID yet, and gains one later without becoming a different peripheral
+ - Define a peripheral the first time it is seen, without counting the definition as an event
+ */
+- (NSUInteger)indexOfPeripheral:(CBPeripheral *)peripheral
+{
+    NSNumber *index = [_peripherals objectForKey:peripheral];
+    if (index) return index.unsignedIntegerValue;
+
+    index = @(_peripherals.count);
+    [_peripherals setObject:index forKey:peripheral];
+
+    CFUUIDBytes bytes = peripheral.UUID ? CFUUIDGetUUIDBytes(peripheral.UUID) : (CFUUIDBytes){ 0 };
+    [self beginRecord:DGKBTraceEventPeripheral];
+    [self appendVarint:index.unsignedIntegerValue];
+    [_buffer appendBytes:&bytes length:sizeof(bytes)];
+    [self appendString:peripheral.name];
+    return index.unsignedIntegerValue;
+}
+
+- (void)appendVarint:(uint64_t)value
+{
+    uint8_t bytes[10];
+    NSUInteger length = 0;
+    do
+    {
+        bytes[length] = value & 0x7f;
+        value >>= 7;
+        if (value) bytes[length] |= 0x80;
+        length++;
+    } while (value);
+    [_buffer appendBytes:bytes length:length];
+}
+
+- (void)appendData:(NSData *)data
+{
+    [self appendVarint:data.length];
+    [_buffer appendData:data];
+}
+
+- (void)appendString:(NSString *)string
+{
+    [self appendData:[string ?: @"" dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)appendUUID:(CBUUID *)UUID
+{
+    [self appendData:UUID.data];
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,102 @@
+//
+//  DGKBEventReplayer.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "DGKBBluetoothScanner.h"
+
+@class DGKBProcessingQueue;
+
+/**
+ @addtogroup Types
+ @{
+ */
+
+/**
+ @typedef DGKBEventReplayCompletionBlockType
+ @brief Event replay completion code block
+
+ The replay reached the end of the trace, or the trace was malformed
+
+ @param eventCount The number of events replayed
+ @param elapsed The wall clock time the replay took
+ */
+typedef void(^DGKBEventReplayCompletionBlockType)(NSUInteger eventCount, NSTimeInterval elapsed);
+
+/** @} */
+
+/**
+ @interface DGKBEventReplayer
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Core Bluetooth event replayer
+
+ Plays back a trace recorded by DGKBEventRecorder. The replayer stands in for the central
+ manager (initialise a DGKBBluetoothScanner with it), and hands its delegate stand-in
+ peripherals, services and characteristics in place of the Core Bluetooth ones, so that the
+ scanner and whatever sits on top of it run exactly as they did when the trace was recorded.
+ Commands sent to the stand-ins (scan, connect, discover, subscribe, write) are ignored; the
+ recorded responses arrive when the trace says they did.
+ @see DGKBEventRecorder
+ */
+@interface DGKBEventReplayer : NSObject <DGKBCentralManager>
+
+/// The replayed central manager state
+@property (readonly) CBCentralManagerState state;
+
+/// The object that receives the replayed events
+@property (nonatomic, weak) id<CBCentralManagerDelegate> delegate;
+
+/// Replay speed: 1 is real time, 10 is ten times faster, 0 is as fast as possible.
+/// Set the scanner's timeScale to the same speed so that its timeouts keep pace with the replayed events;
+/// at 0 there is no pace to keep, and timeouts from the recorded session are not reproduced.
+@property (nonatomic, assign) double speed;
+
+/// The number of events replayed so far, not counting peripheral definitions
+@property (nonatomic, readonly) NSUInteger eventCount;
+
+/// Is a replay in progress?
+@property (nonatomic, readonly) BOOL isReplaying;
+
+/// The queue events are delivered on; hand it the scanner's queue before replaying, as Core Bluetooth would be
+@property (nonatomic, strong) DGKBProcessingQueue *processingQueue;
+
+/**
+ @brief Initialise a replayer with a trace
+ @param trace The trace
+ @return The replayer
+ */
+- (id)initWithTrace:(NSData *)trace;
+
+/**
+ @brief Initialise a replayer with a trace file
+ @param path The trace file path
+ @return The replayer, or nil if the file cannot be read
+ */
+- (id)initWithContentsOfFile:(NSString *)path;
+
+/**
+ @brief Replay the trace from the start
+
+ Events are delivered on the processing queue
+
+ @param block The block to execute when the replay finishes
+ */
+- (void)replayWithCompletion:(DGKBEventReplayCompletionBlockType)block;
+
+/**
+ @brief Stop replaying
+
+ The completion block is not executed
+ */
+- (void)stop;
+
+@end
+
+/** @} */
@@ -0,0 +1,551 @@
+//
+//  DGKBEventReplayer.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBEventReplayer.h"
+#import "DGKBEventRecorder.h"
+#import "DGKBProcessingQueue.h"
+#import "DGKBQueueTimer.h"
+
+@class DGKBReplayService;
+
+/**
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Replayed characteristic
+
+ Stands in for a CBCharacteristic during replay
+ */
+@interface DGKBReplayCharacteristic : NSObject
+
+@property (nonatomic, strong) CBUUID *UUID;                     ///< The characteristic UUID
+@property (nonatomic, assign) CBCharacteristicProperties properties; ///< The characteristic properties
+@property (nonatomic, strong) NSData *value;                    ///< The most recently replayed value
+@property (nonatomic, weak) DGKBReplayService *service;         ///< The service the characteristic belongs to
+@property (nonatomic, assign) BOOL isNotifying;                 ///< Has the listener asked for notifications?
+
+@end
+
+@implementation DGKBReplayCharacteristic
+@end
+
+/**
+ @brief Replayed service
+
+ Stands in for a CBService during replay
+ */
+@interface DGKBReplayService : NSObject
+
+@property (nonatomic, strong) CBUUID *UUID;                     ///< The service UUID
+@property (nonatomic, strong) NSArray *characteristics;         ///< The replayed characteristics
+@property (nonatomic, weak) id peripheral;                      ///< The peripheral the service belongs to
+@property (nonatomic, assign) BOOL isPrimary;                   ///< Is this a primary service?
+
+/**
+ @brief Find a characteristic, adding it if it has not been seen before
+ @param UUID The characteristic UUID
+ @return The characteristic
+ */
+- (DGKBReplayCharacteristic *)characteristicWithUUID:(CBUUID *)UUID;
+
+@end
+
+@implementation DGKBReplayService
+
+- (DGKBReplayCharacteristic *)characteristicWithUUID:(CBUUID *)UUID
+{
+    for (DGKBReplayCharacteristic *characteristic in _characteristics)
+    {
+        if ([characteristic.UUID isEqual:UUID]) return characteristic;
+    }
+    DGKBReplayCharacteristic *characteristic = [[DGKBReplayCharacteristic alloc] init];
+    characteristic.UUID = UUID;
+    characteristic.service = self;
+    _characteristics = [(_characteristics ?: @[]) arrayByAddingObject:characteristic];
+    return characteristic;
+}
+
+@end
+
+/**
+ @brief Replayed peripheral
+
+ Stands in for a CBPeripheral during replay. Commands are accepted and ignored.
+ */
+@interface DGKBReplayPeripheral : NSObject
+
+@property (nonatomic, assign) CFUUIDRef UUID;                   ///< The peripheral UUID (owned)
+@property (nonatomic, strong) NSString *name;                   ///< The peripheral name
+@property (nonatomic, strong) NSNumber *RSSI;                   ///< The most recently replayed RSSI
+@property (nonatomic, strong) NSArray *services;                ///< The replayed services
+@property (nonatomic, weak) id<CBPeripheralDelegate> delegate;  ///< The object that receives peripheral events
+@property (nonatomic, assign) BOOL isConnected;                 ///< Is the peripheral connected in the replay?
+
+/**
+ @brief Find a service, adding it if it has not been seen before
+ @param UUID The service UUID
+ @return The service
+ */
+- (DGKBReplayService *)serviceWithUUID:(CBUUID *)UUID;
+
+@end
+
+@implementation DGKBReplayPeripheral
+
+- (void)dealloc
+{
+    if (_UUID) CFRelease(_UUID);
+}
+
+- (DGKBReplayService *)serviceWithUUID:(CBUUID *)UUID
+{
+    for (DGKBReplayService *service in _services)
+    {
+        if ([service.UUID isEqual:UUID]) return service;
+    }
+    DGKBReplayService *service = [[DGKBReplayService alloc] init];
+    service.UUID = UUID;
+    service.peripheral = self;
+    service.isPrimary = YES;
+    _services = [(_services ?: @[]) arrayByAddingObject:service];
+    return service;
+}
+
+- (void)readRSSI {}
+- (void)discoverServices:(NSArray *)serviceUUIDs {}
+- (void)discoverCharacteristics:(NSArray *)characteristicUUIDs forService:(id)service {}
+- (void)readValueForCharacteristic:(id)characteristic {}
+- (void)writeValue:(NSData *)data forCharacteristic:(id)characteristic type:(CBCharacteristicWriteType)type {}
+
+- (void)setNotifyValue:(BOOL)enabled forCharacteristic:(id)characteristic
+{
+    ((DGKBReplayCharacteristic *)characteristic).isNotifying = enabled;
+}
+
+@end
+
+/** @} */
+
+/**
+ @extends DGKBEventReplayer
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Core Bluetooth event replayer extension
+
+ Internal functionality for the event replayer. Private extensions to DGKBEventReplayer @see DGKBEventReplayer
+ */
+@interface DGKBEventReplayer ()
+
+@property (nonatomic, strong) NSData *trace;                    ///< The trace being replayed
+@property (nonatomic, assign) NSUInteger offset;                ///< The read position in the trace
+@property (nonatomic, assign) DGKBTraceEventType nextType;      ///< The type of the record waiting to be replayed
+@property (nonatomic, strong) NSMutableArray *peripherals;      ///< Replayed peripherals, by index
+@property (nonatomic, assign) NSTimeInterval startTime;         ///< When the replay started
+@property (nonatomic, copy) DGKBEventReplayCompletionBlockType completionBlock; ///< The code block for replay completion
+@property (nonatomic, strong) DGKBQueueTimer *eventTimer;       ///< Fires when the scheduled record is due
+
+/**
+ @brief Read the next record header and schedule it
+
+ - Read the record type and the delay since the previous record
+ - Set up a timer that will call replayNextEvent after the delay, scaled by the replay speed
+ - If there are no more records, finish
+ */
+- (void)scheduleNextEvent;
+/**
+ @brief Replay the scheduled record
+
+ - Read the rest of the record and deliver it to the delegate
+ - Schedule the next record
+ */
+- (void)replayNextEvent;
+/**
+ @brief Finish replaying and execute the completion block
+ */
+- (void)finish;
+
+/**
+ @brief Read the peripheral index at the start of a record
+ @return The peripheral, or nil if the index has not been defined
+ */
+- (DGKBReplayPeripheral *)readPeripheral;
+
+- (BOOL)readByte:(uint8_t *)value;          ///< Read one byte, returns NO at the end of the trace
+- (BOOL)readVarint:(uint64_t *)value;       ///< Read an unsigned LEB128 varint, returns NO if malformed
+- (NSData *)readData;                       ///< Read a length prefixed block of bytes, nil if malformed
+- (NSString *)readString;                   ///< Read a length prefixed UTF-8 string, nil if malformed
+- (CBUUID *)readUUID;                       ///< Read a length prefixed Bluetooth UUID, nil if malformed
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBEventReplayer
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBEventReplayer
+
+- (id)initWithTrace:(NSData *)trace
+{
+    self = [super init];
+    if (self)
+    {
+        _trace = trace;
+        _speed = 1.0;
+        _state = CBCentralManagerStateUnknown;
+        _peripherals = [NSMutableArray array];
+        _processingQueue = [[DGKBProcessingQueue alloc] initWithLabel:@"com.dgkb.blue-mambo.replayer"];
+    }
+    return self;
+}
+
+- (id)initWithContentsOfFile:(NSString *)path
+{
+    NSData *trace = [NSData dataWithContentsOfFile:path];
+    if (!trace) return nil;
+    return [self initWithTrace:trace];
+}
+
+/**
+ - Move onto the processing queue
+ - Check the trace header
+ - Forget any peripherals from an earlier replay
+ - Schedule the first record
+ */
+- (void)replayWithCompletion:(DGKBEventReplayCompletionBlockType)block
+{
+    [_processingQueue async:^{
+        [self stop];
+        _eventTimer = [[DGKBQueueTimer alloc] initWithQueue:_processingQueue];
+        _completionBlock = block;
+        _eventCount = 0;
+        _state = CBCentralManagerStateUnknown;
+        [_peripherals removeAllObjects];
+        _startTime = [[NSProcessInfo processInfo] systemUptime];
+        _isReplaying = YES;
+
+        if (_trace.length < 5 || memcmp(_trace.bytes, DGKBTraceMagic, 4) != 0 || ((const uint8_t *)_trace.bytes)[4] != DGKBTraceVersion)
+        {
+            ERRORLog(@"Not an event trace (version %d)", DGKBTraceVersion);
+            [self finish];
+            return;
+        }
+        _offset = 5;
+        [self scheduleNextEvent];
+    }];
+}
+
+- (void)stop
+{
+    [_processingQueue async:^{
+        [_eventTimer cancel];
+        _isReplaying = NO;
+    }];
+}
+
+- (void)scheduleNextEvent
+{
+    uint8_t type;
+    uint64_t micros;
+    if (![self readByte:&type] || ![self readVarint:&micros])
+    {
+        [self finish];
+        return;
+    }
+    _nextType = type;
+    NSTimeInterval delay = (_speed > 0) ? (micros / 1000000.0) / _speed : 0;
+    __weak DGKBEventReplayer *weakSelf = self;
+    [_eventTimer startWithDelay:delay
+                          block:^{
+                              [weakSelf replayNextEvent];
+                          }];
+}
+
+- (void)replayNextEvent
+{
+    CBCentralManager *central = (CBCentralManager *)self;
+    DGKBReplayPeripheral *peripheral = nil;
+    BOOL valid = YES;
+
+    switch (_nextType)
+    {
+        case DGKBTraceEventState:
+        {
+            uint8_t state;
+            valid = [self readByte:&state];
+            if (!valid) break;
+            _state = state;
+            [_delegate centralManagerDidUpdateState:central];
+            break;
+        }
+        case DGKBTraceEventPeripheral:
+        {
+            uint64_t index;
+            CFUUIDBytes bytes;
+            valid = [self readVarint:&index] && _offset + sizeof(bytes) <= _trace.length;
+            if (!valid) break;
+            memcpy(&bytes, (const uint8_t *)_trace.bytes + _offset, sizeof(bytes));
+            _offset += sizeof(bytes);
+            NSString *name = [self readString];
+            valid = (name != nil && index <= _peripherals.count);
+            if (!valid) break;
+
+            peripheral = [[DGKBReplayPeripheral alloc] init];
+            peripheral.UUID = CFUUIDCreateFromUUIDBytes(NULL, bytes);
+            peripheral.name = name.length ? name : nil;
+            if (index == _peripherals.count) [_peripherals addObject:peripheral];
+            else _peripherals[index] = peripheral;
+            break;
+        }
+        case DGKBTraceEventDiscover:
+        {
+            peripheral = [self readPeripheral];
+            uint8_t rssi;
+            uint64_t count;
+            valid = (peripheral != nil) && [self readByte:&rssi];
+            NSString *localName = valid ? [self readString] : nil;
+            valid = (localName != nil) && [self readVarint:&count];
+            if (!valid) break;
+
+            NSMutableArray *serviceUUIDs = [NSMutableArray array];
+            for (uint64_t i = 0; valid && i < count; i++)
+            {
+                CBUUID *UUID = [self readUUID];
+                valid = (UUID != nil);
+                if (valid) [serviceUUIDs addObject:UUID];
+            }
+            if (!valid) break;
+
+            NSMutableDictionary *advertisementData = [NSMutableDictionary dictionary];
+            if (localName.length) advertisementData[CBAdvertisementDataLocalNameKey] = localName;
+            if (serviceUUIDs.count) advertisementData[CBAdvertisementDataServiceUUIDsKey] = serviceUUIDs;
+            peripheral.RSSI = @((int8_t)rssi);
+            if ([_delegate respondsToSelector:@selector(centralManager:didDiscoverPeripheral:advertisementData:RSSI:)])
+            {
+                [_delegate centralManager:central
+                    didDiscoverPeripheral:(CBPeripheral *)peripheral
+                        advertisementData:advertisementData
+                                     RSSI:peripheral.RSSI];
+            }
+            break;
+        }
+        case DGKBTraceEventConnect:
+            peripheral = [self readPeripheral];
+            valid = (peripheral != nil);
+            if (!valid) break;
+            peripheral.isConnected = YES;
+            if ([_delegate respondsToSelector:@selector(centralManager:didConnectPeripheral:)])
+            {
+                [_delegate centralManager:central
+                     didConnectPeripheral:(CBPeripheral *)peripheral];
+            }
+            break;
+        case DGKBTraceEventFailToConnect:
+            peripheral = [self readPeripheral];
+            valid = (peripheral != nil);
+            if (!valid) break;
+            if ([_delegate respondsToSelector:@selector(centralManager:didFailToConnectPeripheral:error:)])
+            {
+                [_delegate centralManager:central
+               didFailToConnectPeripheral:(CBPeripheral *)peripheral
+                                    error:nil];
+            }
+            break;
+        case DGKBTraceEventDisconnect:
+            peripheral = [self readPeripheral];
+            valid = (peripheral != nil);
+            if (!valid) break;
+            peripheral.isConnected = NO;
+            if ([_delegate respondsToSelector:@selector(centralManager:didDisconnectPeripheral:error:)])
+            {
+                [_delegate centralManager:central
+                  didDisconnectPeripheral:(CBPeripheral *)peripheral
+                                    error:nil];
+            }
+            break;
+        case DGKBTraceEventServices:
+        {
+            peripheral = [self readPeripheral];
+            uint64_t count;
+            valid = (peripheral != nil) && [self readVarint:&count];
+            NSMutableArray *services = [NSMutableArray array];
+            for (uint64_t i = 0; valid && i < count; i++)
+            {
+                CBUUID *UUID = [self readUUID];
+                valid = (UUID != nil);
+                if (valid) [services addObject:[peripheral serviceWithUUID:UUID]];
+            }
+            if (!valid) break;
+            peripheral.services = services;
+            if ([peripheral.delegate respondsToSelector:@selector(peripheral:didDiscoverServices:)])
+            {
+                [peripheral.delegate peripheral:(CBPeripheral *)peripheral
+                            didDiscoverServices:nil];
+            }
+            break;
+        }
+        case DGKBTraceEventCharacteristics:
+        {
+            peripheral = [self readPeripheral];
+            CBUUID *serviceUUID = peripheral ? [self readUUID] : nil;
+            uint64_t count;
+            valid = (serviceUUID != nil) && [self readVarint:&count];
+            if (!valid) break;
+
+            DGKBReplayService *service = [peripheral serviceWithUUID:serviceUUID];
+            NSMutableArray *characteristics = [NSMutableArray array];
+            for (uint64_t i = 0; valid && i < count; i++)
+            {
+                CBUUID *UUID = [self readUUID];
+                uint8_t properties;
+                valid = (UUID != nil) && [self readByte:&properties];
+                if (!valid) break;
+                DGKBReplayCharacteristic *characteristic = [service characteristicWithUUID:UUID];
+                characteristic.properties = properties;
+                [characteristics addObject:characteristic];
+            }
+            if (!valid) break;
+            service.characteristics = characteristics;
+            if ([peripheral.delegate respondsToSelector:@selector(peripheral:didDiscoverCharacteristicsForService:error:)])
+            {
+                [peripheral.delegate peripheral:(CBPeripheral *)peripheral
+           didDiscoverCharacteristicsForService:(CBService *)service
+                                          error:nil];
+            }
+            break;
+        }
+        case DGKBTraceEventValue:
+        {
+            peripheral = [self readPeripheral];
+            CBUUID *serviceUUID = peripheral ? [self readUUID] : nil;
+            CBUUID *characteristicUUID = serviceUUID ? [self readUUID] : nil;
+            NSData *value = characteristicUUID ? [self readData] : nil;
+            valid = (value != nil);
+            if (!valid) break;
+
+            DGKBReplayCharacteristic *characteristic = [[peripheral serviceWithUUID:serviceUUID] characteristicWithUUID:characteristicUUID];
+            characteristic.value = value;
+            if ([peripheral.delegate respondsToSelector:@selector(peripheral:didUpdateValueForCharacteristic:error:)])
+            {
+                [peripheral.delegate peripheral:(CBPeripheral *)peripheral
+                didUpdateValueForCharacteristic:(CBCharacteristic *)characteristic
+                                          error:nil];
+            }
+            break;
+        }
+        default:
+            valid = NO;
+            break;
+    }
+
+    if (!valid)
+    {
+        ERRORLog(@"Malformed trace record (type %d) at offset %ld", _nextType, _offset);
+        [self finish];
+        return;
+    }
+    if (_nextType != DGKBTraceEventPeripheral) _eventCount++;
+    if (_isReplaying) [self scheduleNextEvent];
+}
+
+- (void)finish
+{
+    _isReplaying = NO;
+    NSTimeInterval elapsed = [[NSProcessInfo processInfo] systemUptime] - _startTime;
+    DEBUGLog(@"Replayed %ld event(s) in %1.3fs", _eventCount, elapsed);
+    if (_completionBlock) _completionBlock(_eventCount, elapsed);
+}
+
+#pragma mark - DGKBCentralManager implementation
+
+- (void)scanForPeripheralsWithServices:(NSArray *)serviceUUIDs
+                               options:(NSDictionary *)options
+{
+    DEBUGLog(@"Ignored during replay");
+}
+
+- (void)stopScan
+{
+    DEBUGLog(@"Ignored during replay");
+}
+
+- (void)connectPeripheral:(CBPeripheral *)peripheral
+                  options:(NSDictionary *)options
+{
+    DEBUGLog(@"Ignored during replay");
+}
+
+- (void)cancelPeripheralConnection:(CBPeripheral *)peripheral
+{
+    DEBUGLog(@"Ignored during replay");
+}
+
+#pragma mark - Trace reading
+
+- (DGKBReplayPeripheral *)readPeripheral
+{
+    uint64_t index;
+    if (![self readVarint:&index] || index >= _peripherals.count) return nil;
+    return _peripherals[index];
+}
+
+- (BOOL)readByte:(uint8_t *)value
+{
+    if (_offset >= _trace.length) return NO;
+    *value = ((const uint8_t *)_trace.bytes)[_offset++];
+    return YES;
+}
+
+- (BOOL)readVarint:(uint64_t *)value
+{
+    uint64_t result = 0;
+    uint8_t byte;
+    for (NSUInteger shift = 0; shift < 64; shift += 7)
+    {
+        if (![self readByte:&byte]) return NO;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (NSData *)readData
+{
+    uint64_t length;
+    if (![self readVarint:&length] || length > _trace.length - _offset) return nil;
+    NSData *data = [_trace subdataWithRange:NSMakeRange(_offset, (NSUInteger)length)];
+    _offset += (NSUInteger)length;
+    return data;
+}
+
+- (NSString *)readString
+{
+    NSData *data = [self readData];
+    if (!data) return nil;
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+- (CBUUID *)readUUID
+{
+    NSData *data = [self readData];
+    if (data.length != 2 && data.length != 16) return nil;
+    return [CBUUID UUIDWithData:data];
+}
+
+@end
+
+/** @} */
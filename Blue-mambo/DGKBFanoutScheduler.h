@@ -0,0 +1,206 @@
+//
+//  DGKBFanoutScheduler.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class DGKBSendWindow;
+
+/**
+ @addtogroup Types
+ @{
+ */
+
+/**
+ @typedef DGKBFanoutSendBlockType
+ @brief Fan-out send code block
+
+ Sends one frame to one subscribed central
+
+ @param frame The frame
+ @param central The central
+ @return NO if the frame could not be sent because the transmit queue is full
+ */
+typedef BOOL(^DGKBFanoutSendBlockType)(NSData *frame, CBCentral *central);
+
+/** @} */
+
+/**
+ @def DGKBFanoutCentralKey
+ @brief Lag metrics key for the central's identifier
+ */
+#define DGKBFanoutCentralKey @"central"
+/**
+ @def DGKBFanoutQueuedKey
+ @brief Lag metrics key for the number of notifications waiting for the central's window
+ */
+#define DGKBFanoutQueuedKey @"queued"
+/**
+ @def DGKBFanoutInFlightKey
+ @brief Lag metrics key for the number of notifications sent but not yet acknowledged
+ */
+#define DGKBFanoutInFlightKey @"inFlight"
+/**
+ @def DGKBFanoutAcknowledgedKey
+ @brief Lag metrics key for the number of notifications acknowledged
+ */
+#define DGKBFanoutAcknowledgedKey @"acknowledged"
+/**
+ @def DGKBFanoutRetransmittedKey
+ @brief Lag metrics key for the number of notifications resent
+ */
+#define DGKBFanoutRetransmittedKey @"retransmitted"
+/**
+ @def DGKBFanoutDroppedKey
+ @brief Lag metrics key for the number of notifications discarded because the central fell too far behind
+ */
+#define DGKBFanoutDroppedKey @"dropped"
+/**
+ @def DGKBFanoutSentKey
+ @brief Lag metrics key for the number of frames sent, including resends
+ */
+#define DGKBFanoutSentKey @"sent"
+/**
+ @def DGKBFanoutSentBytesKey
+ @brief Lag metrics key for the number of bytes sent, including resends
+ */
+#define DGKBFanoutSentBytesKey @"sentBytes"
+/**
+ @def DGKBFanoutThroughputKey
+ @brief Lag metrics key for the bytes per second sent since the central subscribed
+ */
+#define DGKBFanoutThroughputKey @"throughput"
+/**
+ @def DGKBFanoutShareKey
+ @brief Lag metrics key for the central's share (0 to 1) of the bytes sent to all subscribed centrals
+ */
+#define DGKBFanoutShareKey @"share"
+/**
+ @def DGKBFanoutAckAgeKey
+ @brief Lag metrics key for the seconds since the central last acknowledged anything
+ */
+#define DGKBFanoutAckAgeKey @"ackAge"
+
+/**
+ @interface DGKBFanoutScheduler
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Per-central fan-out scheduler
+
+ Keeps a subscription table keyed by central, each with its own send window, so that a slow or
+ backlogged central only delays itself. Each time the peripheral manager can take more updates,
+ a deficit round robin decides which central's frames go out: every central with something to
+ send earns a quantum of bytes per round and may send frames while it has credit.
+ @see DGKBSendWindow
+ */
+@interface DGKBFanoutScheduler : NSObject
+
+/// The number of subscribed centrals
+@property (nonatomic, readonly) NSUInteger centralCount;
+
+/**
+ @brief Initialise a fan-out scheduler
+
+ @param windowSize The send window size for each central
+ @param seconds How long to wait for an acknowledgement before resending a frame
+ @param quantum The number of bytes each central may be sent per round
+ @param backlogLimit The number of notifications that may be queued per central
+ @return The scheduler
+ */
+- (id)initWithWindowSize:(NSUInteger)windowSize
+       retransmitTimeout:(NSTimeInterval)seconds
+                 quantum:(NSUInteger)quantum
+            backlogLimit:(NSUInteger)backlogLimit;
+
+/**
+ @brief Add a central to the subscription table
+
+ A central that is already subscribed starts again with an empty window
+
+ @param central The central
+ */
+- (void)addCentral:(CBCentral *)central;
+
+/**
+ @brief Remove a central from the subscription table
+
+ @param central The central
+ */
+- (void)removeCentral:(CBCentral *)central;
+
+/**
+ @brief Remove all centrals from the subscription table
+ */
+- (void)removeAllCentrals;
+
+/**
+ @brief Queue a payload for every subscribed central
+
+ @param payload The payload
+ */
+- (void)enqueuePayload:(NSData *)payload;
+
+/**
+ @brief Queue a payload for one subscribed central
+
+ @param payload The payload
+ @param central The central
+ */
+- (void)enqueuePayload:(NSData *)payload
+             toCentral:(CBCentral *)central;
+
+/**
+ @brief Process an acknowledgement packet from a central
+
+ @param ack The acknowledgement packet
+ @param central The central that wrote it
+ */
+- (void)processAck:(NSData *)ack
+       fromCentral:(CBCentral *)central;
+
+/**
+ @brief Use a send opportunity
+
+ Runs scheduling rounds until no central has anything to send or sendBlock reports that the
+ transmit queue is full. The central that could not be served goes first next time.
+
+ @param sendBlock Code block that sends one frame to one central
+ @return YES if sending stopped because the transmit queue is full
+ */
+- (BOOL)serviceWithBlock:(DGKBFanoutSendBlockType)sendBlock;
+
+/**
+ @brief Get the time until any central's oldest unacknowledged frame is due for retransmission
+
+ @return The number of seconds, or a negative value if nothing is in flight
+ */
+- (NSTimeInterval)timeUntilNextRetransmit;
+
+/**
+ @brief Get lag metrics for each subscribed central
+
+ @return An array of dictionaries, one per central, keyed by the DGKBFanout...Key constants
+ */
+- (NSArray *)lagMetrics;
+
+/**
+ @brief Make the send window for a newly subscribed central
+
+ Subclasses may override this to supply their own windows, such as ones on a simulated clock
+
+ @param windowSize The send window size
+ @param seconds How long to wait for an acknowledgement before resending a frame
+ @return The send window
+ */
+- (DGKBSendWindow *)sendWindowWithSize:(NSUInteger)windowSize
+                     retransmitTimeout:(NSTimeInterval)seconds;
+
+@end
+
+/** @} */
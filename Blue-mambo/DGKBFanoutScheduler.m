@@ -0,0 +1,260 @@
+//
+//  DGKBFanoutScheduler.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBFanoutScheduler.h"
+#import "DGKBSendWindow.h"
+
+/**
+ @brief Get the subscription table key for a central
+ @param central The central
+ @return The central's UUID as a string
+ */
+static NSString *DGKBFanoutKey(CBCentral *central)
+{
+    if (!central.UUID) return [NSString stringWithFormat:@"%p", central];
+    return CFBridgingRelease(CFUUIDCreateString(NULL, central.UUID));
+}
+
+/**
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Fan-out subscriber
+
+ One row of the subscription table
+ */
+@interface DGKBFanoutSubscriber : NSObject
+
+@property (nonatomic, strong) CBCentral *central;           ///< The central
+@property (nonatomic, strong) NSString *key;                ///< The central's key in the subscription table
+@property (nonatomic, strong) DGKBSendWindow *window;       ///< The central's send window
+@property (nonatomic, assign) NSUInteger deficit;           ///< Bytes the central may still be sent this round
+@property (nonatomic, assign) NSTimeInterval subscribedAt;  ///< When the central subscribed, as system uptime
+@property (nonatomic, assign) NSUInteger sentCount;         ///< Frames sent to the central, including resends
+@property (nonatomic, assign) NSUInteger sentByteCount;     ///< Bytes sent to the central, including resends
+
+@end
+
+@implementation DGKBFanoutSubscriber
+@end
+
+/** @} */
+
+/**
+ @extends DGKBFanoutScheduler
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Per-central fan-out scheduler extension
+
+ Internal functionality for the fan-out scheduler. Private extensions to DGKBFanoutScheduler @see DGKBFanoutScheduler
+ */
+@interface DGKBFanoutScheduler ()
+
+@property (nonatomic, strong) NSMutableDictionary *table;   ///< Subscribers keyed by central
+@property (nonatomic, strong) NSMutableArray *subscribers;  ///< Subscribers in round robin order
+@property (nonatomic, assign) NSUInteger cursor;            ///< The subscriber that is served first in the next round
+@property (nonatomic, assign) NSUInteger windowSize;        ///< The send window size for each central
+@property (nonatomic, assign) NSTimeInterval retransmitTimeout; ///< The retransmit timeout for each central
+@property (nonatomic, assign) NSUInteger quantum;           ///< The bytes each central earns per round
+@property (nonatomic, assign) NSUInteger backlogLimit;      ///< The backlog limit for each central
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBFanoutScheduler
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBFanoutScheduler
+
+- (id)initWithWindowSize:(NSUInteger)windowSize
+       retransmitTimeout:(NSTimeInterval)seconds
+                 quantum:(NSUInteger)quantum
+            backlogLimit:(NSUInteger)backlogLimit
+{
+    self = [super init];
+    if (self)
+    {
+        _windowSize = windowSize;
+        _retransmitTimeout = seconds;
+        _quantum = MAX(1, quantum);
+        _backlogLimit = backlogLimit;
+        _table = [NSMutableDictionary dictionary];
+        _subscribers = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSUInteger)centralCount
+{
+    return _subscribers.count;
+}
+
+/**
+ - Replace any existing row for the central
+ - Give the central a fresh send window
+ */
+- (void)addCentral:(CBCentral *)central
+{
+    [self removeCentral:central];
+
+    DGKBFanoutSubscriber *subscriber = [[DGKBFanoutSubscriber alloc] init];
+    subscriber.central = central;
+    subscriber.key = DGKBFanoutKey(central);
+    subscriber.window = [self sendWindowWithSize:_windowSize
+                               retransmitTimeout:_retransmitTimeout];
+    subscriber.window.backlogLimit = _backlogLimit;
+    subscriber.subscribedAt = [[NSProcessInfo processInfo] systemUptime];
+
+    _table[subscriber.key] = subscriber;
+    [_subscribers addObject:subscriber];
+}
+
+- (void)removeCentral:(CBCentral *)central
+{
+    NSString *key = DGKBFanoutKey(central);
+    DGKBFanoutSubscriber *subscriber = _table[key];
+    if (!subscriber) return;
+
+    NSUInteger index = [_subscribers indexOfObject:subscriber];
+    [_subscribers removeObjectAtIndex:index];
+    [_table removeObjectForKey:key];
+    if (index < _cursor) _cursor--;
+    if (_cursor >= _subscribers.count) _cursor = 0;
+}
+
+- (void)removeAllCentrals
+{
+    [_table removeAllObjects];
+    [_subscribers removeAllObjects];
+    _cursor = 0;
+}
+
+- (void)enqueuePayload:(NSData *)payload
+{
+    for (DGKBFanoutSubscriber *subscriber in _subscribers)
+    {
+        [subscriber.window enqueuePayload:payload];
+    }
+}
+
+- (void)enqueuePayload:(NSData *)payload
+             toCentral:(CBCentral *)central
+{
+    DGKBFanoutSubscriber *subscriber = _table[DGKBFanoutKey(central)];
+    [subscriber.window enqueuePayload:payload];
+}
+
+- (void)processAck:(NSData *)ack
+       fromCentral:(CBCentral *)central
+{
+    DGKBFanoutSubscriber *subscriber = _table[DGKBFanoutKey(central)];
+    [subscriber.window processAck:ack];
+}
+
+/**
+ - Visit each subscriber in turn, starting from the cursor
+ - A subscriber with nothing to send loses its credit
+ - Otherwise it earns a quantum and sends frames while they fit in its credit
+ - Stop as soon as the transmit queue is full, leaving the cursor on the subscriber that missed out
+ - Keep going round until a whole round sends nothing
+ */
+- (BOOL)serviceWithBlock:(DGKBFanoutSendBlockType)sendBlock
+{
+    NSUInteger count = _subscribers.count;
+    BOOL active = (count > 0);
+    while (active)
+    {
+        active = NO;
+        for (NSUInteger visited = 0; visited < count; visited++)
+        {
+            DGKBFanoutSubscriber *subscriber = _subscribers[_cursor];
+            NSData *frame = [subscriber.window nextFrame];
+            if (frame)
+            {
+                active = YES;
+                subscriber.deficit += _quantum;
+                while (frame && frame.length <= subscriber.deficit)
+                {
+                    if (!sendBlock(frame, subscriber.central)) return YES;
+                    [subscriber.window didSendFrame];
+                    subscriber.sentCount++;
+                    subscriber.sentByteCount += frame.length;
+                    subscriber.deficit -= frame.length;
+                    frame = [subscriber.window nextFrame];
+                }
+            }
+            if (!frame) subscriber.deficit = 0;
+            _cursor = (_cursor + 1) % count;
+        }
+    }
+    return NO;
+}
+
+- (NSTimeInterval)timeUntilNextRetransmit
+{
+    NSTimeInterval soonest = -1;
+    for (DGKBFanoutSubscriber *subscriber in _subscribers)
+    {
+        NSTimeInterval delay = [subscriber.window timeUntilNextRetransmit];
+        if (delay < 0) continue;
+        if (soonest < 0 || delay < soonest) soonest = delay;
+    }
+    return soonest;
+}
+
+/**
+ - Total the bytes sent to every subscriber, so each one's share can be worked out
+ - Report each subscriber's window counters, what it has been sent and how long since it last acknowledged anything
+ */
+- (NSArray *)lagMetrics
+{
+    NSTimeInterval now = [[NSProcessInfo processInfo] systemUptime];
+    NSUInteger totalBytes = 0;
+    for (DGKBFanoutSubscriber *subscriber in _subscribers)
+    {
+        totalBytes += subscriber.sentByteCount;
+    }
+    NSMutableArray *metrics = [NSMutableArray arrayWithCapacity:_subscribers.count];
+    for (DGKBFanoutSubscriber *subscriber in _subscribers)
+    {
+        DGKBSendWindow *window = subscriber.window;
+        NSTimeInterval lastAck = window.lastAckTime > 0 ? window.lastAckTime : subscriber.subscribedAt;
+        NSTimeInterval subscribed = now - subscriber.subscribedAt;
+        [metrics addObject:@{
+                             DGKBFanoutCentralKey : subscriber.key,
+                             DGKBFanoutQueuedKey : @(window.backlogCount),
+                             DGKBFanoutInFlightKey : @(window.inFlightCount),
+                             DGKBFanoutAcknowledgedKey : @(window.acknowledgedCount),
+                             DGKBFanoutRetransmittedKey : @(window.retransmitCount),
+                             DGKBFanoutDroppedKey : @(window.droppedCount),
+                             DGKBFanoutSentKey : @(subscriber.sentCount),
+                             DGKBFanoutSentBytesKey : @(subscriber.sentByteCount),
+                             DGKBFanoutThroughputKey : @(subscribed > 0 ? subscriber.sentByteCount / subscribed : 0.0),
+                             DGKBFanoutShareKey : @(totalBytes > 0 ? (double)subscriber.sentByteCount / totalBytes : 0.0),
+                             DGKBFanoutAckAgeKey : @(now - lastAck)
+                             }];
+    }
+    return metrics;
+}
+
+- (DGKBSendWindow *)sendWindowWithSize:(NSUInteger)windowSize
+                     retransmitTimeout:(NSTimeInterval)seconds
+{
+    return [[DGKBSendWindow alloc] initWithWindowSize:windowSize
+                                    retransmitTimeout:seconds];
+}
+
+@end
+
+/** @} */
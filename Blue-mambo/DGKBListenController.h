@@ -47,6 +47,12 @@
  */
 - (IBAction)didPressDisconnectButton:(id)sender;
 
+/**
+ @brief Get the listen pipeline's stage latency percentiles
+ @return The report, one line per stage @see DGKBPipelineTrace
+ */
+- (NSString *)pipelineReport;
+
 @end
 
 /** @} */
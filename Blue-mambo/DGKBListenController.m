@@ -9,10 +9,30 @@
 #import "DGKBListenController.h"
 #import "BlueCommon.h"
 #import "DGKBBluetoothScanner.h"
+#import "DGKBReceiveWindow.h"
+#import "DGKBEventRecorder.h"
+#import "DGKBEventReplayer.h"
+#import "DGKBPipelineTrace.h"
+#import "DGKBSampleCodec.h"
+#import "DGKBScanScheduler.h"
+#import "DGKBProcessingQueue.h"
+#import "DGKBQueueTimer.h"
+#import "DGKBViewSnapshot.h"
+#import "DGKBSnapshotChannel.h"
 
 #define DGKBBlueScanningTimeout 10.0
 #define DGKBBlueConnectionTimeout 10.0
 #define DGKBBlueRequestTimeout 20.0
+#define DGKBBlueScanWindow 2.0          // Scan 80% of the time while searching
+#define DGKBBlueScanInterval 2.5
+#define DGKBBlueMaximumScanPause 30.0
+#define DGKBBlueRecordTrace FALSE       // Record scanner events to DGKBBlueTraceFile
+#define DGKBBlueReplayTrace FALSE       // Drive the scanner from DGKBBlueTraceFile instead of Core Bluetooth
+#define DGKBBlueReplaySpeed 1.0         // Timeouts are scaled to match; 0 replays as fast as possible, without reproducing timeouts
+#define DGKBBlueTraceFile @"listen.dgkbtrace"
+#define DGKBBlueAnimationLoad FALSE     // Keep the main thread busy, as a heavy animation would, while measuring value latency
+#define DGKBBlueAnimationLoadShare 0.5  // The share of each frame the animation load keeps the main thread busy
+#define DGKBBlueSampleLogInterval 1.0   // How often the sample summary is added to the log
 #define SCREENCOLOUR [UIColor colorWithRed:0.25 green:0.5 blue:1.0 alpha:1.0]
 
 /**
@@ -32,26 +52,82 @@
 @property (nonatomic, strong) NSArray *characteristicUUIDs;             ///< The characteristic UUIDs to scan for
 
 @property (nonatomic, strong) DGKBBluetoothScanner *scanner;            ///< The scanner
+@property (nonatomic, strong) DGKBEventReplayer *replayer;              ///< Replays recorded events through the scanner, if replaying
+@property (nonatomic, strong) DGKBPipelineTrace *pipelineTrace;         ///< Listen pipeline stage latencies
 @property (nonatomic) BOOL scanState;                                   ///< Are we currently scanning?
 
 @property(nonatomic, strong) CBPeripheral *connectedPeripheral;         ///< The currently connected peripheral
 @property(nonatomic, strong) CBService *connectedService;               ///< The connected's peripheral's current service
 
 @property(nonatomic, strong) CBCharacteristic *replyCharacteristic;     ///< Reply characteristics
+@property(nonatomic, strong) DGKBReceiveWindow *receiveWindow;          ///< Notifications received but not yet acknowledged
+@property(nonatomic, strong) DGKBSampleCodec *sampleCodec;              ///< Decodes batched samples
+@property(nonatomic, assign) NSUInteger sampleCount;                    ///< The number of samples received since subscribing
+@property(nonatomic, assign) NSTimeInterval firstSampleTime;            ///< When the first sample since subscribing arrived, as system uptime
+@property(nonatomic, assign) NSTimeInterval sampleLogTime;              ///< When the sample summary was last added to the log
 
 @property(nonatomic, assign) BOOL subscribeWhenCharacteristicsFound;    ///< Should we subscribe to any found characteristics?
 @property(nonatomic, assign) BOOL connectWhenReady;                     ///< Should we connect when Bluetooth is ready?
 
+@property(nonatomic, strong) DGKBQueueTimer *requestTimer;              ///< Times the request out
+@property(nonatomic, strong) DGKBQueueTimer *ackTimer;                  ///< Fires when the coalesced acknowledgement is due
+
+@property(nonatomic, strong) DGKBMutableViewSnapshot *viewModel;        ///< What the screen should show, kept on the scanner's processing queue
+@property(nonatomic, strong) DGKBSnapshotChannel *snapshotChannel;      ///< Hands view model snapshots to the main thread
+@property(nonatomic, strong) DGKBViewSnapshot *appliedSnapshot;         ///< The snapshot the screen is showing
+@property(nonatomic, strong) NSTimer *animationLoadTimer;               ///< Busies the main thread every frame, if measuring under animation load
+
 /**
  @brief Show the Bluetooth status
  @param message Message to display
  @param colour Colour to display the message
  
- - Display the message in the centralManagerStatus label
+ - Put the message in the view model and publish it
  */
 - (void)showStatus:(NSString *)message
          andColour:(UIColor *)colour;
 
+/**
+ @brief Publish a snapshot of the view model to the main thread
+ */
+- (void)publishViewModel;
+
+/**
+ @brief Show a view model snapshot; runs on the main thread
+ @param snapshot The snapshot
+ 
+ - Update the labels, the log report, the scan button, the activity indicator and the disconnect button
+ - Pulse the screen once for any connections or disconnections since the last snapshot
+ - Record how long the latest value took to reach the screen
+ */
+- (void)applySnapshot:(DGKBViewSnapshot *)snapshot;
+
+/**
+ @brief Pulse the screen; runs on the main thread
+ @param colour The colour to pulse
+ */
+- (void)pulseColour:(UIColor *)colour;
+
+/**
+ @brief Start the animation load; runs on the main thread
+ 
+ - Set up a timer that will call animationLoadDidFire every frame
+ */
+- (void)startAnimationLoad;
+/**
+ @brief Stop the animation load; runs on the main thread
+ 
+ - Remove the timer that was set up to load the main thread
+ */
+- (void)stopAnimationLoad;
+/**
+ @brief Handle an animation load frame
+ @param timer The timer
+ 
+ - Keep the main thread busy for DGKBBlueAnimationLoadShare of the frame
+ */
+- (void)animationLoadDidFire:(NSTimer *)timer;
+
 /**
  @brief Get a description for a central manager's state
  @param state A central manager state
@@ -61,6 +137,12 @@
  */
 - (NSString *)getCBCentralStateName:(CBCentralManagerState) state;
 
+/**
+ @brief Get the path of the event trace file
+ @return The path, in the app's documents directory
+ */
+- (NSString *)tracePath;
+
 /**
  @brief Will start scanning for peripherals
  */
@@ -104,6 +186,20 @@
  */
 - (void)didFindCharacteristics:(CBService *)service;
 
+/**
+ @brief A subscribed characteristic changed value
+ @param characteristic The characteristic
+ 
+ - Discard the frame if DGKBBlueDropFrames is simulating loss
+ - Pass the frame through the receive window
+ - Decode any payloads that are sample frames and show a summary of the samples
+ - Show any other payloads that can now be delivered as text
+ - Publish one view model snapshot for the whole frame, stamped with when the callback arrived
+ - Record how long the frame took to process
+ - Schedule an acknowledgement
+ */
+- (void)didReceiveValueForCharacteristic:(CBCharacteristic *)characteristic;
+
 /**
  @brief We are about to subscribe to the characteristics
  */
@@ -117,7 +213,7 @@
 /**
  @brief Show UI when peripheral connects
  
- - Pulse the screen green
+ - Ask the screen to pulse green
  - Show the disconnect button
  */
 
@@ -125,7 +221,7 @@
 /**
  @brief Show UI when peripheral disconnects
  
- - Pulse the screen red
+ - Ask the screen to pulse red
  - Hide the disconnect button
  */
 - (void)peripheralDidDisconnect;
@@ -154,6 +250,27 @@
  */
 - (void)requestDidTimeout:(CBCharacteristic *)characteristic;
 
+/**
+ @brief Start acknowledgement monitor
+ 
+ - Send an acknowledgement now if half the window is unacknowledged
+ - Otherwise, unless the monitor is already running, set up a timer that will call ackDidTimeout after ACKINTERVAL,
+   so that steady traffic cannot keep putting the acknowledgement off
+ */
+- (void)startAckMonitor;
+/**
+ @brief Cancel the acknowledgement monitor
+ 
+ - Remove the timer that was set up to coalesce acknowledgements
+ */
+- (void)cancelAckMonitor;
+/**
+ @brief Handle acknowledgement timeout
+ 
+ - Write the coalesced acknowledgement to the reply characteristic, without response
+ */
+- (void)ackDidTimeout;
+
 @end
 
 /** @} */
@@ -165,9 +282,13 @@
  */
 @implementation DGKBListenController
 
-- (void)viewDidAppear:(BOOL)animated
+/**
+ - Create the scanner, and so its processing queue and central manager, once for the life of the screen
+ - Create the timers, the view model and the snapshot channel, which all work with the scanner's queue
+ */
+- (void)viewDidLoad
 {
-    [super viewDidAppear:animated];
+    [super viewDidLoad];
     
     _serviceUUIDs = @[
                       [CBUUID UUIDWithString:SERVICEUUID],
@@ -178,15 +299,76 @@
                              ];
 
     // Initialize scanner
-    _scanner = [[DGKBBluetoothScanner alloc]init];
+#if (DGKBBlueReplayTrace == TRUE)
+    _replayer = [[DGKBEventReplayer alloc] initWithContentsOfFile:[self tracePath]];
+    if (_replayer)
+    {
+        _replayer.speed = DGKBBlueReplaySpeed;
+        _scanner = [[DGKBBluetoothScanner alloc] initWithCentralManager:_replayer];
+        _scanner.timeScale = DGKBBlueReplaySpeed;   // So the scanner's timeouts keep pace with the replay
+        _replayer.processingQueue = _scanner.processingQueue;
+    }
+#endif
+    if (!_scanner) _scanner = [[DGKBBluetoothScanner alloc]init];
+    _pipelineTrace = [[DGKBPipelineTrace alloc] init];
+    
+    // Everything from here on, apart from applying view model snapshots, runs on the scanner's processing queue.
+    _requestTimer = [[DGKBQueueTimer alloc] initWithQueue:_scanner.processingQueue];
+    _ackTimer = [[DGKBQueueTimer alloc] initWithQueue:_scanner.processingQueue];
+    _viewModel = [[DGKBMutableViewSnapshot alloc] init];
+    __weak DGKBListenController *weakSelf = self;
+    _snapshotChannel = [[DGKBSnapshotChannel alloc] initWithConsumer:^(id snapshot)
+                                                                     {
+                                                                         [weakSelf applySnapshot:snapshot];
+                                                                     }];
+    [_scanner.processingQueue sync:^{
+        _scanner.pipelineTrace = _pipelineTrace;
+        _scanner.scanScheduler = [[DGKBScanScheduler alloc] initWithWindow:DGKBBlueScanWindow
+                                                                  interval:DGKBBlueScanInterval];
+        _scanner.scanScheduler.maximumPause = DGKBBlueMaximumScanPause;
+    }];
+}
+
+- (void)viewDidAppear:(BOOL)animated
+{
+    [super viewDidAppear:animated];
+    
+    [_scanner.processingQueue sync:^{
+#if (DGKBBlueRecordTrace == TRUE)
+        _scanner.recorder = [[DGKBEventRecorder alloc] init];
+#endif
+        if (_replayer)
+        {
+            // Scanning is deferred until the replayed manager powers on.
+            [self willStartScanning];
+            [_replayer replayWithCompletion:^(NSUInteger eventCount, NSTimeInterval elapsed)
+                                            {
+                                                DEBUGLog(@"Replayed %ld event(s) in %1.3fs", eventCount, elapsed);
+                                            }];
+        }
+    }];
+#if (DGKBBlueAnimationLoad == TRUE)
+    [self startAnimationLoad];
+#endif
 }
 
 - (void)viewDidDisappear:(BOOL)animated
 {
-    [_scanner disconnect:_connectedPeripheral];
-    _connectedPeripheral = nil;
-    [_scanner stopScanning];
-    _scanner = nil;
+    [_scanner.processingQueue sync:^{
+        [self cancelAckMonitor];
+        [_scanner disconnect:_connectedPeripheral];
+        _connectedPeripheral = nil;
+        [_scanner stopScanning];
+        if (_scanner.recorder)
+        {
+            DEBUGLog(@"Recorded %ld event(s)", _scanner.recorder.eventCount);
+            [_scanner.recorder writeToFile:[self tracePath]];
+            _scanner.recorder = nil;
+        }
+        [_replayer stop];
+    }];
+    [self stopAnimationLoad];
+    [_pipelineTrace logPercentiles];
     [super viewDidDisappear:animated];
 }
 
@@ -201,8 +383,89 @@
 - (void)showStatus:(NSString *)message
          andColour:(UIColor *)colour
 {
-    _centralManagerStatus.text = message;
-    _centralManagerStatus.textColor = colour;
+    _viewModel.statusText = message;
+    _viewModel.statusColour = colour;
+    [self publishViewModel];
+}
+
+- (void)publishViewModel
+{
+    [_snapshotChannel publish:[_viewModel copy]];
+}
+
+- (void)applySnapshot:(DGKBViewSnapshot *)snapshot
+{
+    if (snapshot.statusText)
+    {
+        _centralManagerStatus.text = snapshot.statusText;
+        _centralManagerStatus.textColor = snapshot.statusColour;
+    }
+    if (snapshot.bluetoothStatus)
+    {
+        _hostBluetoothStatus.text = snapshot.bluetoothStatus;
+        _hostBluetoothStatus.textColor = [UIColor whiteColor];
+    }
+    if (snapshot.logText != _appliedSnapshot.logText) _reportLog.text = snapshot.logText;
+    [_scanButton setTitle: snapshot.scanning ? @"Stop" : @"Scan"
+                 forState: UIControlStateNormal];
+    if (snapshot.scanning) [self.centralManagerActivityIndicator startAnimating];
+    else [self.centralManagerActivityIndicator stopAnimating];
+    _disconnectButton.hidden = !snapshot.connected;
+    if (snapshot.connectPulseCount != _appliedSnapshot.connectPulseCount) [self pulseColour:[UIColor greenColor]];
+    if (snapshot.disconnectPulseCount != _appliedSnapshot.disconnectPulseCount) [self pulseColour:[UIColor redColor]];
+    if (snapshot.valueTimestamp != _appliedSnapshot.valueTimestamp)
+    {
+        [_pipelineTrace recordLatencySince:snapshot.valueTimestamp
+                                  forStage:DGKBPipelineValueDisplayed];
+    }
+    _appliedSnapshot = snapshot;
+}
+
+- (void)pulseColour:(UIColor *)colour
+{
+    [UIView animateWithDuration:0.1
+                     animations:^{
+                         self.view.backgroundColor = colour;
+                     }
+                     completion:^(BOOL finished) {
+                         [UIView animateWithDuration:0.1
+                                          animations:^{
+                                              self.view.backgroundColor = SCREENCOLOUR;
+                                          }];
+                     }];
+}
+
+- (void)startAnimationLoad
+{
+    [self stopAnimationLoad];
+    _animationLoadTimer = [NSTimer timerWithTimeInterval:1.0 / 60.0
+                                                  target:self
+                                                selector:@selector(animationLoadDidFire:)
+                                                userInfo:nil
+                                                 repeats:YES];
+    [[NSRunLoop mainRunLoop] addTimer:_animationLoadTimer
+                              forMode:NSRunLoopCommonModes];
+}
+
+- (void)stopAnimationLoad
+{
+    [_animationLoadTimer invalidate];
+    _animationLoadTimer = nil;
+}
+
+- (void)animationLoadDidFire:(NSTimer *)timer
+{
+    NSTimeInterval until = [[NSProcessInfo processInfo] systemUptime] + DGKBBlueAnimationLoadShare / 60.0;
+    while ([[NSProcessInfo processInfo] systemUptime] < until)
+    {
+        // Stand in for the main thread work of a heavy animation
+    }
+}
+
+- (NSString *)tracePath
+{
+    NSString *documents = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+    return [documents stringByAppendingPathComponent:DGKBBlueTraceFile];
 }
 
 - (NSString *)getCBCentralStateName:(CBCentralManagerState) state
@@ -238,18 +501,15 @@
 
 - (void)willStartScanning
 {
-    [_scanButton setTitle: @"Stop"
-                 forState: UIControlStateNormal];
-
     DEBUGLog(@"Scan Starting");
 
-    [self showStatus:@"Scanning for all services." andColour:[UIColor greenColor]];
-
-    [self.centralManagerActivityIndicator startAnimating];
+    _viewModel.scanning = YES;
+    [self showStatus:@"Scanning for the service." andColour:[UIColor greenColor]];
     
     _scanState = YES;  // scanning
     
-    [_scanner startScanningWithTimeout:DGKBBlueScanningTimeout
+    [_scanner startScanningForServices:_serviceUUIDs
+                           withTimeout:DGKBBlueScanningTimeout
                      onFoundPeripheral:^(CBPeripheral *peripheral, NSDictionary *advertisementData, NSNumber *RSSI)
                                        {
                                            [self didFindPeripheral:peripheral
@@ -270,13 +530,9 @@
 - (void)didStopScanning
 {
     DEBUGLog(@"");
-    [self.centralManagerActivityIndicator stopAnimating];
+    _viewModel.scanning = NO;
     [self showStatus:@"Idle"
            andColour:[UIColor blackColor]];
-    _centralManagerStatus.textColor = [UIColor blackColor];
-    
-    [_scanButton setTitle: @"Scan"
-                 forState: UIControlStateNormal];
     _scanState = NO;
 }
 
@@ -332,6 +588,7 @@
     // TODO: This does not deal with multiple devices advertising the same service
     //       yet.
     if (!foundSuitablePeripheral) return;
+    [_pipelineTrace markStage:DGKBPipelineFirstAdvert];
     [_scanner stopScanning];
     [self didStopScanning];
     DEBUGLog(@"Connecting ... %@", UUID);
@@ -346,6 +603,7 @@
                    onDisconnect:^
                                 {
                                     DEBUGLog(@"%@ Disconnected", peripheral.name);
+                                    [_pipelineTrace logPercentiles];
                                     _connectedPeripheral = nil;
                                     _connectedService = nil;
          
@@ -407,18 +665,7 @@
                                          }
                  onChangedCharacteristic:^(CBCharacteristic *characteristic)
                                          {
-                                            DEBUGLog(@"%@ Value: %@", characteristic, characteristic.value);
-                                            NSString *printable = [[NSString alloc] initWithData:characteristic.value encoding:NSUTF8StringEncoding];
-                                            DEBUGLog(@"Text: %@", printable);
-                                            _reportLog.text = [NSString stringWithFormat:@"%@%@\n", _reportLog.text, printable];
-                                                 
-    //                                         if (_replyCharacteristic != nil)
-    //                                         {
-    //                                             DEBUGLog(@"Send ACK back");
-    //                                             [peripheral writeValue:[@"ACK" dataUsingEncoding:NSUTF8StringEncoding]
-    //                                                  forCharacteristic:_replyCharacteristic
-    //                                                               type:CBCharacteristicWriteWithResponse];
-    //                                         }             
+                                             [self didReceiveValueForCharacteristic:characteristic];
                                          }];
         }
     }
@@ -430,7 +677,7 @@
     DEBUGLog(@"Found %ld characteristic(s)", service.characteristics.count);
     for (CBCharacteristic *characteristic in service.characteristics) {
         DEBUGLog(@"Characteristic: %@ (%ld)", characteristic.UUID, characteristic.properties);
-        if (characteristic.properties & CBCharacteristicPropertyWrite) _replyCharacteristic = characteristic;
+        if (characteristic.properties & (CBCharacteristicPropertyWrite | CBCharacteristicPropertyWriteWithoutResponse)) _replyCharacteristic = characteristic;
     }
     
     if (service.characteristics.count < 1) {
@@ -441,6 +688,10 @@
         return;
     }
     
+    // The broadcaster restarts its sequence numbers for each new subscription.
+    _receiveWindow = [[DGKBReceiveWindow alloc] initWithWindowSize:ACKWINDOWSIZE];
+    _sampleCodec = [[DGKBSampleCodec alloc] initWithFrameLength:SAMPLEFRAMELENGTH keyframeInterval:SAMPLEKEYFRAMEINTERVAL];
+    _sampleCount = 0;
     for (CBCharacteristic *characteristic in service.characteristics) {
         if (characteristic.properties & CBCharacteristicPropertyNotify) {
             [_connectedPeripheral setNotifyValue:YES
@@ -451,6 +702,58 @@
     //    [self.delegate centralClientDidSubscribe:self];
 }
 
+- (void)didReceiveValueForCharacteristic:(CBCharacteristic *)characteristic
+{
+    int64_t arrived = [DGKBPipelineTrace timestamp];
+    DEBUGLog(@"%@ Value: %@", characteristic, characteristic.value);
+#if (DGKBBlueDropFrames == TRUE)
+    if (arc4random_uniform(100) < DGKBBlueDropPercentage)
+    {
+        DEBUGLog(@"Dropped %@", characteristic.value);
+        return;
+    }
+#endif
+    for (NSData *payload in [_receiveWindow payloadsForFrame:characteristic.value])
+    {
+        if ([DGKBSampleCodec isSampleFrame:payload.bytes length:payload.length])
+        {
+            int32_t samples[DGKBSampleMaxPerFrame];
+            NSInteger count = [_sampleCodec decodeFrame:payload.bytes
+                                                 length:payload.length
+                                            intoSamples:samples
+                                               capacity:DGKBSampleMaxPerFrame];
+            if (count <= 0)
+            {
+                DEBUGLog(@"Sample frame %@", count == 0 ? @"skipped until next keyframe" : @"malformed");
+                continue;
+            }
+            NSTimeInterval now = [[NSProcessInfo processInfo] systemUptime];
+            if (_sampleCount == 0)
+            {
+                _firstSampleTime = now;
+                _sampleLogTime = now - DGKBBlueSampleLogInterval;
+            }
+            _sampleCount += count;
+            // Summarise rather than logging every frame, which would outpace the log at the generator's rate.
+            if (now - _sampleLogTime < DGKBBlueSampleLogInterval) continue;
+            _sampleLogTime = now;
+            NSTimeInterval elapsed = now - _firstSampleTime;
+            [_viewModel appendLogLine:[NSString stringWithFormat:@"%ld samples, last %d (%.0f/s)",
+                                       (long)_sampleCount, samples[count - 1],
+                                       elapsed > 0 ? _sampleCount / elapsed : 0.0]];
+            continue;
+        }
+        NSString *printable = [[NSString alloc] initWithData:payload encoding:NSUTF8StringEncoding];
+        DEBUGLog(@"Text: %@", printable);
+        [_viewModel appendLogLine:printable];
+    }
+    _viewModel.valueTimestamp = arrived;
+    [self publishViewModel];
+    [_pipelineTrace recordLatencySince:arrived
+                              forStage:DGKBPipelineValueProcessed];
+    [self startAckMonitor];
+}
+
 // Does all the necessary things to find the device and make a connection.
 - (void)willConnect
 {
@@ -506,7 +809,7 @@
                                          DEBUGLog(@"Found %ld characteristic(s)", service.characteristics.count);
                                          for (CBCharacteristic *characteristic in service.characteristics) {
                                              DEBUGLog(@"Characteristic: %@ (%ld)", characteristic.UUID, characteristic.properties);
-                                             if (characteristic.properties & CBCharacteristicPropertyWrite) _replyCharacteristic = characteristic;
+                                             if (characteristic.properties & (CBCharacteristicPropertyWrite | CBCharacteristicPropertyWriteWithoutResponse)) _replyCharacteristic = characteristic;
                                          }
                                          
                                          // If we did discover characteristics, these will get remembered in the
@@ -522,6 +825,9 @@
                                              return;
                                          }
                                          
+                                         _receiveWindow = [[DGKBReceiveWindow alloc] initWithWindowSize:ACKWINDOWSIZE];
+                                         _sampleCodec = [[DGKBSampleCodec alloc] initWithFrameLength:SAMPLEFRAMELENGTH keyframeInterval:SAMPLEKEYFRAMEINTERVAL];
+                                         _sampleCount = 0;
                                          for (CBCharacteristic *characteristic in service.characteristics) {
                                              if (characteristic.properties & CBCharacteristicPropertyNotify) {
                                                  [self.connectedPeripheral setNotifyValue:YES
@@ -531,18 +837,7 @@
                                      }
              onChangedCharacteristic:^(CBCharacteristic *characteristic)
                                      {
-                                         DEBUGLog(@"%@ Value: %@", characteristic, characteristic.value);
-                                         NSString *printable = [[NSString alloc] initWithData:characteristic.value encoding:NSUTF8StringEncoding];
-                                         DEBUGLog(@"Text: %@", printable);
-                                         _reportLog.text = [NSString stringWithFormat:@"%@%@\n", _reportLog.text, printable];
-                                         
-//                                         if (_replyCharacteristic != nil)
-//                                         {
-//                                             DEBUGLog(@"Send ACK back");
-//                                             [peripheral writeValue:[@"ACK" dataUsingEncoding:NSUTF8StringEncoding]
-//                                                  forCharacteristic:_replyCharacteristic
-//                                                               type:CBCharacteristicWriteWithResponse];
-//                                         }             
+                                         [self didReceiveValueForCharacteristic:characteristic];
                                      }];
         return;
     }
@@ -567,17 +862,19 @@
 
 - (void)startRequestTimeoutMonitor:(CBCharacteristic *)characteristic
 {
-    [self cancelRequestTimeoutMonitor:characteristic];
-    [self performSelector:@selector(requestDidTimeout:)
-               withObject:characteristic
-               afterDelay:DGKBBlueRequestTimeout];
+    __weak DGKBListenController *weakSelf = self;
+    [_requestTimer startWithDelay:DGKBBlueRequestTimeout
+                            block:^{
+                                [weakSelf requestDidTimeout:characteristic];
+                            }];
 }
 
+/**
+ - Only one request is monitored at a time, so the characteristic is not needed
+ */
 - (void)cancelRequestTimeoutMonitor:(CBCharacteristic *)characteristic
 {
-    [NSObject cancelPreviousPerformRequestsWithTarget:self
-                                             selector:@selector(requestDidTimeout:)
-                                               object:characteristic];
+    [_requestTimer cancel];
 }
 
 - (void)requestDidTimeout:(CBCharacteristic *)characteristic
@@ -591,61 +888,83 @@
                            forCharacteristic:characteristic];
 }
 
+- (void)startAckMonitor
+{
+    if (_receiveWindow.unacknowledgedCount >= _receiveWindow.windowSize / 2)
+    {
+        [self ackDidTimeout];
+        return;
+    }
+    if (_ackTimer.isScheduled) return;
+    __weak DGKBListenController *weakSelf = self;
+    [_ackTimer startWithDelay:ACKINTERVAL
+                        block:^{
+                            [weakSelf ackDidTimeout];
+                        }];
+}
+
+- (void)cancelAckMonitor
+{
+    [_ackTimer cancel];
+}
+
+- (void)ackDidTimeout
+{
+    [self cancelAckMonitor];
+    if (!_replyCharacteristic || !_connectedPeripheral) return;
+    if (_receiveWindow.unacknowledgedCount == 0) return;
+    
+    [_connectedPeripheral writeValue:[_receiveWindow ackPacket]
+                   forCharacteristic:_replyCharacteristic
+                                type:CBCharacteristicWriteWithoutResponse];
+}
+
 
 - (void)peripheralDidConnect
 {
-    [UIView animateWithDuration:0.1
-                     animations:^{
-                         self.view.backgroundColor = [UIColor greenColor];
-                     }
-                     completion:^(BOOL finished) {
-                         [UIView animateWithDuration:0.1
-                                          animations:^{
-                                              self.view.backgroundColor = SCREENCOLOUR;
-                                          }];
-                         [self showStatus:[NSString stringWithFormat:@"Connected %@", _connectedPeripheral.RSSI]
-                                andColour:[UIColor greenColor]];
-                         _disconnectButton.hidden = NO;
-                     }];
+    [_viewModel pulseConnect];
+    _viewModel.connected = YES;
+    [self showStatus:[NSString stringWithFormat:@"Connected %@", _connectedPeripheral.RSSI]
+           andColour:[UIColor greenColor]];
 }
 
 - (void)peripheralDidDisconnect
 {
-    [UIView animateWithDuration:0.1
-                     animations:^{
-                         self.view.backgroundColor = [UIColor redColor];
-                     }
-                     completion:^(BOOL finished) {
-                         [UIView animateWithDuration:0.1
-                                          animations:^{
-                                              self.view.backgroundColor = SCREENCOLOUR;
-                                          }];
-                         [self showStatus:@"Idle"
-                                andColour:[UIColor blackColor]];
-                         _disconnectButton.hidden = YES;
-                     }];
+    [_viewModel pulseDisconnect];
+    _viewModel.connected = NO;
+    [self showStatus:@"Idle"
+           andColour:[UIColor blackColor]];
+}
+
+- (NSString *)pipelineReport
+{
+    return [_pipelineTrace dump];
 }
 
 #pragma mark - UI Action handlers
 
 - (IBAction)didPressScanButton:(id)sender
 {
-    if (! _scanState)
-    {
-        [self willStartScanning];
-    }
-    else
-    {
-        [_scanner stopScanning];
-        [self didStopScanning];
-    }
+    [_scanner.processingQueue async:^{
+        if (! _scanState)
+        {
+            [self willStartScanning];
+        }
+        else
+        {
+            [_scanner stopScanning];
+            [self didStopScanning];
+        }
+    }];
 }
 
 - (void)didPressDisconnectButton:(id)sender
 {
-    [self didStopScanning];
-    [_scanner disconnect:_connectedPeripheral];
-    _connectedPeripheral = nil;
+    [_scanner.processingQueue async:^{
+        [self didStopScanning];
+        [_scanner disconnect:_connectedPeripheral];
+        _connectedPeripheral = nil;
+    }];
 }
 
 #pragma mark - CBCentralManager delegate implementation
@@ -653,8 +972,8 @@
 - (void)centralManagerDidUpdateState:(CBCentralManager *)central
 {
     DEBUGLog(@"%@", central);
-    _hostBluetoothStatus.text = [self getCBCentralStateName:central.state];
-    _hostBluetoothStatus.textColor = [UIColor whiteColor];
+    _viewModel.bluetoothStatus = [self getCBCentralStateName:central.state];
+    [self publishViewModel];
 
     switch (central.state) {
         case CBCentralManagerStatePoweredOn:
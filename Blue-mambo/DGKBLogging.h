@@ -17,7 +17,7 @@
  First #define LOW_LEVEL_DEBUG as TRUE\n
  Then import Logging.h
 
- Subsequently use DEBUGLog or ERRORLog where you might use NSLog
+ Subsequently use DEBUGLog or ERRORLog where you might use NSLog, and TRACELog for pipeline trace reports
  
  DEBUGLog will only log output if LOW_LEVEL_DEBUG is TRUE, ERRORLog will always log output
  
@@ -92,6 +92,7 @@
 #endif
 
 #define ERRORLog(...) LogMessageF(__FILE__, __LINE__, __PRETTY_FUNCTION__, @"Error", 0, @"%@", [NSString stringWithFormat:__VA_ARGS__])
+#define TRACELog(...) LogMessageF(__FILE__, __LINE__, __PRETTY_FUNCTION__, @"Trace", 1, @"%@", [NSString stringWithFormat:__VA_ARGS__])
 
 #else
 
@@ -108,6 +109,12 @@
 #endif
 
 #define ERRORLog(...) NSLog(@"%s %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:__VA_ARGS__])
+/**
+ @def TRACELog
+ @param ... Content to log
+ @brief Logs pipeline trace reports. Like ERRORLog, this always logs output
+ */
+#define TRACELog(...) NSLog(@"%s %@", __PRETTY_FUNCTION__, [NSString stringWithFormat:__VA_ARGS__])
 
 #endif
 
@@ -0,0 +1,132 @@
+//
+//  DGKBPipelineTrace.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @addtogroup Types
+ @{
+ */
+
+/**
+ @typedef DGKBPipelineStage
+ @brief Listen pipeline stages
+
+ The stages a listen pipeline passes through, in order. DGKBPipelineTotal is not a stage; its
+ histogram holds the end to end latency from scan start to first value. The stages after it
+ are not part of a run either: they time every value, and are recorded with
+ recordLatencySince:forStage: rather than marked.
+ */
+typedef enum
+{
+    DGKBPipelineScanStart = 0,          ///< Scanning started
+    DGKBPipelineFirstAdvert,            ///< The first advert from a suitable peripheral arrived
+    DGKBPipelineConnectRequested,       ///< A connection was requested
+    DGKBPipelineConnected,              ///< The peripheral connected
+    DGKBPipelineServicesFound,          ///< The peripheral's services were found
+    DGKBPipelineCharacteristicsFound,   ///< The service's characteristics were found
+    DGKBPipelineNotifyEnabled,          ///< Notifications were enabled on a characteristic
+    DGKBPipelineFirstValue,             ///< The first value arrived
+    DGKBPipelineTotal,                  ///< Scan start to first value
+    DGKBPipelineValueProcessed,         ///< Each value, from its callback to the processing queue having handled it
+    DGKBPipelineValueDisplayed,         ///< Each value, from its callback to the main thread showing it
+    DGKBPipelineStageCount
+} DGKBPipelineStage;
+
+/** @} */
+
+/**
+ @interface DGKBPipelineTrace
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Listen pipeline tracing
+
+ Timestamps each stage of the listen pipeline with a monotonic clock and collects the time
+ each stage took (since the previous stage that was reached) into a per-stage histogram.
+
+ The histograms are log-linear in the style of HDR histograms: 16 linear sub-buckets per power
+ of two microseconds, so every percentile is within about 6% of the recorded value. Recording is
+ lock-free (atomic counter increments), so stages can be marked from any thread while another
+ thread reads percentiles. Each mark is tagged with the run it was made in, so a stage marked
+ for one run can never be taken as reached in the next.
+ */
+@interface DGKBPipelineTrace : NSObject
+
+/**
+ @brief Mark a stage as reached
+
+ DGKBPipelineScanStart begins a new pipeline run. Every other stage is only recorded the first
+ time it is reached in a run, so repeated adverts or values do not skew the histograms. Stages
+ reached before the first scan start are ignored.
+
+ @param stage The stage
+ */
+- (void)markStage:(DGKBPipelineStage)stage;
+
+/**
+ @brief Record one value's latency
+
+ Only for the stages after DGKBPipelineTotal
+
+ @param timestamp When the value's callback arrived @see timestamp
+ @param stage The stage
+ */
+- (void)recordLatencySince:(int64_t)timestamp
+                  forStage:(DGKBPipelineStage)stage;
+
+/**
+ @brief Get the number of times a stage has been recorded
+ @param stage The stage
+ @return The count
+ */
+- (uint64_t)countForStage:(DGKBPipelineStage)stage;
+
+/**
+ @brief Get a latency percentile for a stage
+ @param percentile The percentile (0 to 100)
+ @param stage The stage
+ @return The latency in microseconds, or 0 if the stage has not been recorded
+ */
+- (uint64_t)microsecondsAtPercentile:(double)percentile
+                            forStage:(DGKBPipelineStage)stage;
+
+/**
+ @brief Get a report of every stage's count and percentiles
+ @return The report, one line per stage
+ */
+- (NSString *)dump;
+
+/**
+ @brief Send the report to the trace log channel
+ @see TRACELog
+ */
+- (void)logPercentiles;
+
+/**
+ @brief Discard everything recorded so far
+ */
+- (void)reset;
+
+/**
+ @brief Read the clock that stages are timed with
+ @return Nanoseconds since an arbitrary point, unaffected by changes to the wall clock
+ */
++ (int64_t)timestamp;
+
+/**
+ @brief Get a stage's name
+ @param stage The stage
+ @return The name
+ */
++ (NSString *)nameForStage:(DGKBPipelineStage)stage;
+
+@end
+
+/** @} */
@@ -0,0 +1,359 @@
+//
+//  DGKBPipelineTrace.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBPipelineTrace.h"
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+
+/**
+ @def DGKBSubBucketBits
+ @brief Each power of two is split into 2^DGKBSubBucketBits linear sub-buckets
+ */
+#define DGKBSubBucketBits 4
+/**
+ @def DGKBSubBucketCount
+ @brief The number of linear sub-buckets per power of two
+ */
+#define DGKBSubBucketCount (1 << DGKBSubBucketBits)
+/**
+ @def DGKBBucketCount
+ @brief The number of buckets per histogram, enough for latencies up to 2^40 microseconds
+ */
+#define DGKBBucketCount (DGKBSubBucketCount * (40 - DGKBSubBucketBits + 2))
+/**
+ @def DGKBMarkTimeBits
+ @brief The low bits of a mark hold when the stage was reached, in microseconds (modulo about 12 days)
+ */
+#define DGKBMarkTimeBits 40
+/**
+ @def DGKBMarkTimeMask
+ @brief Selects the time from a mark
+ */
+#define DGKBMarkTimeMask ((1LL << DGKBMarkTimeBits) - 1)
+/**
+ @def DGKBMarkRunMask
+ @brief Selects the run from the high bits of a mark, leaving the sign bit clear
+ */
+#define DGKBMarkRunMask ((1LL << (63 - DGKBMarkTimeBits)) - 1)
+
+/**
+ @brief Read the monotonic clock
+ @return Nanoseconds since an arbitrary point, unaffected by changes to the wall clock
+ */
+static int64_t DGKBMonotonicNanoseconds(void)
+{
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        mach_timebase_info(&timebase);
+    });
+    return (int64_t)(mach_absolute_time() * timebase.numer / timebase.denom);
+}
+
+/**
+ @brief Make a stage mark
+ @param run The pipeline run the mark belongs to
+ @param microseconds When the stage was reached
+ @return The mark
+ */
+static int64_t DGKBMakeMark(int64_t run, int64_t microseconds)
+{
+    return ((run & DGKBMarkRunMask) << DGKBMarkTimeBits) | (microseconds & DGKBMarkTimeMask);
+}
+
+/**
+ @brief Get the pipeline run a stage mark belongs to
+ @param mark The mark
+ @return The run (0 if the stage has never been reached)
+ */
+static int64_t DGKBMarkRun(int64_t mark)
+{
+    return mark >> DGKBMarkTimeBits;
+}
+
+/**
+ @brief Get the time between two stage marks
+ @param from The earlier mark
+ @param to The later mark
+ @return The elapsed time in microseconds
+ */
+static int64_t DGKBMarkInterval(int64_t from, int64_t to)
+{
+    return ((to & DGKBMarkTimeMask) - (from & DGKBMarkTimeMask)) & DGKBMarkTimeMask;
+}
+
+/**
+ @brief Atomically replace a 64 bit value
+ @param value The new value
+ @param target The value to replace
+ */
+static void DGKBAtomicStore64(int64_t value, volatile int64_t *target)
+{
+    int64_t previous;
+    do
+    {
+        previous = *target;
+    } while (!OSAtomicCompareAndSwap64Barrier(previous, value, target));
+}
+
+/**
+ @brief Atomically replace a 32 bit value
+ @param value The new value
+ @param target The value to replace
+ */
+static void DGKBAtomicStore32(int32_t value, volatile int32_t *target)
+{
+    int32_t previous;
+    do
+    {
+        previous = *target;
+    } while (!OSAtomicCompareAndSwap32Barrier(previous, value, target));
+}
+
+/**
+ @brief Find the histogram bucket for a value
+ @param value The value
+ @return The bucket index
+ */
+static NSUInteger DGKBBucketForValue(uint64_t value)
+{
+    if (value < DGKBSubBucketCount) return (NSUInteger)value;
+    unsigned shift = (63 - __builtin_clzll(value)) - DGKBSubBucketBits;
+    NSUInteger index = DGKBSubBucketCount * (shift + 1) + (NSUInteger)((value >> shift) - DGKBSubBucketCount);
+    return MIN(index, DGKBBucketCount - 1);
+}
+
+/**
+ @brief Find the largest value that falls in a histogram bucket
+ @param index The bucket index
+ @return The value
+ */
+static uint64_t DGKBHighestValueInBucket(NSUInteger index)
+{
+    if (index < DGKBSubBucketCount) return index;
+    unsigned shift = (unsigned)(index / DGKBSubBucketCount) - 1;
+    uint64_t mantissa = DGKBSubBucketCount + (index % DGKBSubBucketCount);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ @extends DGKBPipelineTrace
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Listen pipeline tracing extension
+
+ Internal functionality for pipeline tracing. Private extensions to DGKBPipelineTrace @see DGKBPipelineTrace
+ */
+@interface DGKBPipelineTrace ()
+{
+    volatile int64_t _run;                                              ///< The current pipeline run, counted up by each scan start (0 before the first)
+    volatile int64_t _marks[DGKBPipelineStageCount];                    ///< When each stage was last reached, tagged with the run it was reached in
+    volatile int64_t _totals[DGKBPipelineStageCount];                   ///< How many times each stage has been recorded
+    volatile int32_t _buckets[DGKBPipelineStageCount][DGKBBucketCount]; ///< Each stage's latency histogram
+}
+
+/**
+ @brief Add a latency to a stage's histogram
+ @param nanoseconds The latency
+ @param stage The stage
+ */
+- (void)recordNanoseconds:(int64_t)nanoseconds
+                 forStage:(DGKBPipelineStage)stage;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBPipelineTrace
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBPipelineTrace
+
+/**
+ - Scan start begins a new run; marks tagged with an earlier run count as not reached, so nothing needs clearing
+ - Any other stage is only recorded the first time it is reached in the current run. The mark is
+   swapped in only while the slot still holds an earlier run's mark, so a stage marked for a run
+   that has since been superseded is never counted as reached in the new one
+ - Its latency is measured from the latest earlier stage reached in the same run
+ - The first value also records the end to end latency
+ */
+- (void)markStage:(DGKBPipelineStage)stage
+{
+    if (stage >= DGKBPipelineTotal) return;
+    int64_t now = DGKBMonotonicNanoseconds() / 1000;
+
+    if (stage == DGKBPipelineScanStart)
+    {
+        int64_t run = OSAtomicIncrement64Barrier(&_run) & DGKBMarkRunMask;
+        DGKBAtomicStore64(DGKBMakeMark(run, now), &_marks[DGKBPipelineScanStart]);
+        return;
+    }
+
+    int64_t run = _run & DGKBMarkRunMask;
+    if (run == 0) return;
+    int64_t mark = DGKBMakeMark(run, now);
+    int64_t previousMark;
+    do
+    {
+        previousMark = _marks[stage];
+        if (DGKBMarkRun(previousMark) == run) return;
+    } while (!OSAtomicCompareAndSwap64Barrier(previousMark, mark, &_marks[stage]));
+
+    for (NSInteger previous = stage - 1; previous >= DGKBPipelineScanStart; previous--)
+    {
+        int64_t then = _marks[previous];
+        if (DGKBMarkRun(then) != run) continue;
+        [self recordNanoseconds:DGKBMarkInterval(then, mark) * 1000
+                       forStage:stage];
+        break;
+    }
+    int64_t start = _marks[DGKBPipelineScanStart];
+    if (stage == DGKBPipelineFirstValue && DGKBMarkRun(start) == run)
+    {
+        [self recordNanoseconds:DGKBMarkInterval(start, mark) * 1000
+                       forStage:DGKBPipelineTotal];
+    }
+}
+
+- (void)recordLatencySince:(int64_t)timestamp
+                  forStage:(DGKBPipelineStage)stage
+{
+    if (stage <= DGKBPipelineTotal || stage >= DGKBPipelineStageCount || timestamp == 0) return;
+    [self recordNanoseconds:DGKBMonotonicNanoseconds() - timestamp
+                   forStage:stage];
+}
+
+- (void)recordNanoseconds:(int64_t)nanoseconds
+                 forStage:(DGKBPipelineStage)stage
+{
+    uint64_t microseconds = (uint64_t)MAX(0, nanoseconds) / 1000;
+    OSAtomicIncrement32Barrier(&_buckets[stage][DGKBBucketForValue(microseconds)]);
+    OSAtomicIncrement64Barrier(&_totals[stage]);
+}
+
+- (uint64_t)countForStage:(DGKBPipelineStage)stage
+{
+    if (stage >= DGKBPipelineStageCount) return 0;
+    return (uint64_t)_totals[stage];
+}
+
+/**
+ - Walk the buckets until the running count reaches the requested share of the total
+ - Report the largest value in that bucket
+ */
+- (uint64_t)microsecondsAtPercentile:(double)percentile
+                            forStage:(DGKBPipelineStage)stage
+{
+    if (stage >= DGKBPipelineStageCount) return 0;
+
+    uint64_t counts[DGKBBucketCount];
+    uint64_t total = 0;
+    for (NSUInteger index = 0; index < DGKBBucketCount; index++)
+    {
+        counts[index] = (uint32_t)_buckets[stage][index];
+        total += counts[index];
+    }
+    if (total == 0) return 0;
+
+    double share = MAX(0.0, MIN(100.0, percentile)) / 100.0;
+    uint64_t target = MAX(1, (uint64_t)ceil(share * total));
+    uint64_t seen = 0;
+    for (NSUInteger index = 0; index < DGKBBucketCount; index++)
+    {
+        seen += counts[index];
+        if (seen >= target) return DGKBHighestValueInBucket(index);
+    }
+    return DGKBHighestValueInBucket(DGKBBucketCount - 1);
+}
+
+- (NSString *)dump
+{
+    NSMutableString *report = [NSMutableString stringWithFormat:@"%@ %8s %8s %8s %8s %8s (ms)\n",
+                               [@"Stage" stringByPaddingToLength:22 withString:@" " startingAtIndex:0],
+                               "count", "p50", "p90", "p99", "max"];
+    for (NSUInteger stage = DGKBPipelineFirstAdvert; stage < DGKBPipelineStageCount; stage++)
+    {
+        NSString *name = [[DGKBPipelineTrace nameForStage:stage] stringByPaddingToLength:22
+                                                                              withString:@" "
+                                                                         startingAtIndex:0];
+        [report appendFormat:@"%@ %8llu %8.1f %8.1f %8.1f %8.1f\n",
+         name,
+         [self countForStage:stage],
+         [self microsecondsAtPercentile:50.0 forStage:stage] / 1000.0,
+         [self microsecondsAtPercentile:90.0 forStage:stage] / 1000.0,
+         [self microsecondsAtPercentile:99.0 forStage:stage] / 1000.0,
+         [self microsecondsAtPercentile:100.0 forStage:stage] / 1000.0];
+    }
+    return report;
+}
+
+- (void)logPercentiles
+{
+    TRACELog(@"\n%@", [self dump]);
+}
+
+/**
+ - Move on to a new run, which leaves every mark behind
+ - Clear the counts and histograms
+ */
+- (void)reset
+{
+    OSAtomicIncrement64Barrier(&_run);
+    for (NSUInteger stage = 0; stage < DGKBPipelineStageCount; stage++)
+    {
+        DGKBAtomicStore64(0, &_totals[stage]);
+        for (NSUInteger index = 0; index < DGKBBucketCount; index++)
+        {
+            DGKBAtomicStore32(0, &_buckets[stage][index]);
+        }
+    }
+}
+
++ (int64_t)timestamp
+{
+    return DGKBMonotonicNanoseconds();
+}
+
++ (NSString *)nameForStage:(DGKBPipelineStage)stage
+{
+    switch (stage)
+    {
+        case DGKBPipelineScanStart:
+            return @"Scan start";
+        case DGKBPipelineFirstAdvert:
+            return @"First advert";
+        case DGKBPipelineConnectRequested:
+            return @"Connect requested";
+        case DGKBPipelineConnected:
+            return @"Connected";
+        case DGKBPipelineServicesFound:
+            return @"Services found";
+        case DGKBPipelineCharacteristicsFound:
+            return @"Characteristics found";
+        case DGKBPipelineNotifyEnabled:
+            return @"Notify enabled";
+        case DGKBPipelineFirstValue:
+            return @"First value";
+        case DGKBPipelineTotal:
+            return @"Total";
+        case DGKBPipelineValueProcessed:
+            return @"Value processed";
+        case DGKBPipelineValueDisplayed:
+            return @"Value displayed";
+        default:
+            return @"Unknown";
+    }
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,62 @@
+//
+//  DGKBProcessingQueue.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @interface DGKBProcessingQueue
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Serial Bluetooth processing queue
+
+ A serial dispatch queue that Core Bluetooth delivers its delegate callbacks on, and that the
+ scanner, the controllers' state machines and their timers all run on, keeping that work off
+ the main thread. Work submitted from code that is already running on the queue runs straight
+ away, so calls made from inside a callback keep their order.
+ */
+@interface DGKBProcessingQueue : NSObject
+
+/// The dispatch queue, to hand to a Core Bluetooth manager
+@property (nonatomic, readonly) dispatch_queue_t queue;
+
+/**
+ @brief Initialise a processing queue
+ @param label The queue's label, for the debugger and crash reports
+ @return The queue
+ */
+- (id)initWithLabel:(NSString *)label;
+
+/**
+ @brief Is the caller running on this queue?
+ @return YES if it is
+ */
+- (BOOL)isCurrent;
+
+/**
+ @brief Run a block on the queue without waiting for it
+
+ Runs the block straight away if the caller is already on the queue
+
+ @param block The block
+ */
+- (void)async:(dispatch_block_t)block;
+
+/**
+ @brief Run a block on the queue and wait for it to finish
+
+ Never call this from the queue's own work while it waits for the main thread
+
+ @param block The block
+ */
+- (void)sync:(dispatch_block_t)block;
+
+@end
+
+/** @} */
@@ -0,0 +1,53 @@
+//
+//  DGKBProcessingQueue.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBProcessingQueue.h"
+
+/**
+ @brief The key each processing queue tags its dispatch queue with, so it can tell when it is current
+ */
+static char DGKBProcessingQueueKey;
+
+/**
+ @implements DGKBProcessingQueue
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBProcessingQueue
+
+- (id)initWithLabel:(NSString *)label
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = dispatch_queue_create([label UTF8String], DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(_queue, &DGKBProcessingQueueKey, (__bridge void *)self, NULL);
+    }
+    return self;
+}
+
+- (BOOL)isCurrent
+{
+    return dispatch_get_specific(&DGKBProcessingQueueKey) == (__bridge void *)self;
+}
+
+- (void)async:(dispatch_block_t)block
+{
+    if ([self isCurrent]) block();
+    else dispatch_async(_queue, block);
+}
+
+- (void)sync:(dispatch_block_t)block
+{
+    if ([self isCurrent]) block();
+    else dispatch_sync(_queue, block);
+}
+
+@end
+
+/** @} */
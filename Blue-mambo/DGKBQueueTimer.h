@@ -0,0 +1,56 @@
+//
+//  DGKBQueueTimer.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class DGKBProcessingQueue;
+
+/**
+ @interface DGKBQueueTimer
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief One shot timer on a processing queue
+
+ Stands in for performSelector:withObject:afterDelay: and cancelPreviousPerformRequestsWithTarget:,
+ which need a run loop that a dispatch queue does not have. Each start or cancel bumps a
+ generation number; a timer that fires after a later start or cancel finds the generation has
+ moved on and does nothing. Only start and cancel the timer from its queue.
+ */
+@interface DGKBQueueTimer : NSObject
+
+/// Is the timer waiting to fire?
+@property (nonatomic, readonly) BOOL isScheduled;
+
+/**
+ @brief Initialise a timer
+ @param queue The queue to run the timer's block on
+ @return The timer
+ */
+- (id)initWithQueue:(DGKBProcessingQueue *)queue;
+
+/**
+ @brief Start the timer, cancelling it first if it is already running
+
+ The block should only hold its owner weakly, so the timer does not keep it alive
+
+ @param seconds The delay
+ @param block The block to execute when the timer fires
+ */
+- (void)startWithDelay:(NSTimeInterval)seconds
+                 block:(dispatch_block_t)block;
+
+/**
+ @brief Cancel the timer
+ */
+- (void)cancel;
+
+@end
+
+/** @} */
@@ -0,0 +1,74 @@
+//
+//  DGKBQueueTimer.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBQueueTimer.h"
+#import "DGKBProcessingQueue.h"
+
+/**
+ @extends DGKBQueueTimer
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Queue timer extension
+
+ Internal functionality for the queue timer. Private extensions to DGKBQueueTimer @see DGKBQueueTimer
+ */
+@interface DGKBQueueTimer ()
+
+@property (nonatomic, strong) DGKBProcessingQueue *queue;   ///< The queue the timer fires on
+@property (nonatomic, assign) NSUInteger generation;        ///< Bumped by every start and cancel
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBQueueTimer
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBQueueTimer
+
+- (id)initWithQueue:(DGKBProcessingQueue *)queue
+{
+    self = [super init];
+    if (self)
+    {
+        _queue = queue;
+    }
+    return self;
+}
+
+/**
+ - Bump the generation, which cancels any earlier start
+ - Dispatch the block after the delay, if the generation has not moved on by then
+ */
+- (void)startWithDelay:(NSTimeInterval)seconds
+                 block:(dispatch_block_t)block
+{
+    NSUInteger generation = ++_generation;
+    _isScheduled = YES;
+    __weak DGKBQueueTimer *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(MAX(0, seconds) * NSEC_PER_SEC)), _queue.queue, ^{
+        DGKBQueueTimer *timer = weakSelf;
+        if (!timer || timer.generation != generation) return;
+        timer->_isScheduled = NO;
+        block();
+    });
+}
+
+- (void)cancel
+{
+    _generation++;
+    _isScheduled = NO;
+}
+
+@end
+
+/** @} */
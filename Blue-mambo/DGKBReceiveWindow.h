@@ -0,0 +1,57 @@
+//
+//  DGKBReceiveWindow.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @interface DGKBReceiveWindow
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Sliding receive window
+
+ Receiver half of the windowed acknowledgement protocol. Frames that arrive out of order are held
+ until the gap before them is filled, duplicates are dropped, and the frames seen so far are
+ summarised in a single acknowledgement packet so that acknowledgements can be coalesced.
+ @see DGKBSendWindow
+ */
+@interface DGKBReceiveWindow : NSObject
+
+/// The number of frames that may be held waiting for a missing frame
+@property (nonatomic, readonly) NSUInteger windowSize;
+
+/// The number of frames received since the last acknowledgement packet was built
+@property (nonatomic, readonly) NSUInteger unacknowledgedCount;
+
+/**
+ @brief Initialise a receive window
+
+ @param windowSize The sender's window size (clamped to DGKBAckWindowMax)
+ @return The receive window
+ */
+- (id)initWithWindowSize:(NSUInteger)windowSize;
+
+/**
+ @brief Accept a frame from the sender
+
+ @param frame The frame, including its sequence number header
+ @return The payloads that can now be delivered, in order (may be empty)
+ */
+- (NSArray *)payloadsForFrame:(NSData *)frame;
+
+/**
+ @brief Build an acknowledgement packet for everything received so far
+
+ @return The acknowledgement packet
+ */
+- (NSData *)ackPacket;
+
+@end
+
+/** @} */
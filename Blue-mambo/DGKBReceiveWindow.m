@@ -0,0 +1,106 @@
+//
+//  DGKBReceiveWindow.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBReceiveWindow.h"
+#import "DGKBSendWindow.h"
+
+/**
+ @extends DGKBReceiveWindow
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Sliding receive window extension
+
+ Internal functionality for the receive window. Private extensions to DGKBReceiveWindow @see DGKBReceiveWindow
+ */
+@interface DGKBReceiveWindow ()
+
+@property (nonatomic, strong) NSMutableArray *held;     ///< Out of order payloads, indexed by slot
+@property (nonatomic, assign) uint16_t expected;        ///< The next sequence number to deliver
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBReceiveWindow
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBReceiveWindow
+
+- (id)initWithWindowSize:(NSUInteger)windowSize
+{
+    self = [super init];
+    if (self)
+    {
+        _windowSize = MAX(1, MIN(windowSize, DGKBAckWindowMax));
+        _held = [NSMutableArray arrayWithCapacity:DGKBAckWindowMax];
+        for (NSUInteger slot = 0; slot < DGKBAckWindowMax; slot++)
+        {
+            [_held addObject:[NSNull null]];
+        }
+    }
+    return self;
+}
+
+/**
+ - Frames before the expected sequence number are duplicates, but still need acknowledging
+ - Frames beyond the window are dropped; the sender will resend them
+ - Hold the payload, then deliver everything from the expected sequence number up to the next gap
+ */
+- (NSArray *)payloadsForFrame:(NSData *)frame
+{
+    if (frame.length < 2) return @[];
+
+    const uint8_t *bytes = frame.bytes;
+    uint16_t sequence = (uint16_t)(bytes[0] | (bytes[1] << 8));
+    int16_t offset = (int16_t)(sequence - _expected);
+
+    _unacknowledgedCount++;
+    if (offset < 0 || offset >= (int16_t)_windowSize) return @[];
+
+    NSUInteger slot = sequence & (DGKBAckWindowMax - 1);
+    if (_held[slot] == [NSNull null])
+    {
+        _held[slot] = [frame subdataWithRange:NSMakeRange(2, frame.length - 2)];
+    }
+
+    NSMutableArray *payloads = [NSMutableArray array];
+    while (_held[_expected & (DGKBAckWindowMax - 1)] != [NSNull null])
+    {
+        slot = _expected & (DGKBAckWindowMax - 1);
+        [payloads addObject:_held[slot]];
+        _held[slot] = [NSNull null];
+        _expected++;
+    }
+    return payloads;
+}
+
+- (NSData *)ackPacket
+{
+    uint32_t bitmap = 0;
+    for (NSUInteger bit = 0; bit + 1 < _windowSize; bit++)
+    {
+        uint16_t sequence = (uint16_t)(_expected + 1 + bit);
+        if (_held[sequence & (DGKBAckWindowMax - 1)] != [NSNull null]) bitmap |= (1u << bit);
+    }
+    _unacknowledgedCount = 0;
+
+    uint8_t packet[6] = {
+        (uint8_t)(_expected & 0xff), (uint8_t)(_expected >> 8),
+        (uint8_t)(bitmap & 0xff), (uint8_t)((bitmap >> 8) & 0xff),
+        (uint8_t)((bitmap >> 16) & 0xff), (uint8_t)(bitmap >> 24)
+    };
+    return [NSData dataWithBytes:packet length:sizeof(packet)];
+}
+
+@end
+
+/** @} */
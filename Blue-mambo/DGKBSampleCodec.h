@@ -0,0 +1,124 @@
+//
+//  DGKBSampleCodec.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @def DGKBSampleRawMarker
+ @brief First byte of a frame holding one raw sample (little-endian int32)
+ */
+#define DGKBSampleRawMarker 0xFD
+/**
+ @def DGKBSampleDeltaMarker
+ @brief First byte of a frame whose first sample is relative to the previous frame's last sample
+ */
+#define DGKBSampleDeltaMarker 0xFE
+/**
+ @def DGKBSampleKeyframeMarker
+ @brief First byte of a frame whose first sample is absolute
+ */
+#define DGKBSampleKeyframeMarker 0xFF
+/**
+ @def DGKBSampleCodecMaxFrameLength
+ @brief The largest frame the codec will build
+ */
+#define DGKBSampleCodecMaxFrameLength 512
+/**
+ @def DGKBSampleMaxPerFrame
+ @brief The most samples in a frame, so that the count always fits in one varint byte; size decode buffers with this
+ */
+#define DGKBSampleMaxPerFrame 127
+
+/**
+ @interface DGKBSampleCodec
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Delta/varint sample codec
+
+ Batches integer samples into notification sized frames. A batched frame is a marker byte,
+ a frame sequence number (1 byte), the sample count (varint) and the samples, each one the
+ zigzag varint of its difference from the sample before it. Every keyframeInterval frames
+ the first sample is sent as an absolute value instead, so a listener that missed a frame
+ can pick up again.
+
+ The marker bytes can never start a UTF-8 string, so sample frames can share a characteristic
+ with text. The broadcaster uses the encoding half and the listener the decoding half. The
+ decoder itself writes into a caller supplied buffer and does not allocate; the receive window
+ and the log report the listener feeds it from still allocate for each frame.
+ */
+@interface DGKBSampleCodec : NSObject
+
+/**
+ @brief Initialise a codec
+
+ @param frameLength The largest frame to build (at most DGKBSampleCodecMaxFrameLength)
+ @param keyframeInterval How often, in frames, to send a keyframe
+ @return The codec
+ */
+- (id)initWithFrameLength:(NSUInteger)frameLength
+         keyframeInterval:(NSUInteger)keyframeInterval;
+
+/**
+ @brief Add a sample to the current frame
+
+ @param sample The sample
+ @return The previous frame, if the sample did not fit in it, otherwise nil
+ */
+- (NSData *)addSample:(int32_t)sample;
+
+/**
+ @brief Finish the current frame
+
+ @return The frame, or nil if it has no samples
+ */
+- (NSData *)flush;
+
+/**
+ @brief Make the next frame a keyframe, for example when a new listener subscribes
+ */
+- (void)requestKeyframe;
+
+/**
+ @brief Build a frame holding one raw sample
+
+ @param sample The sample
+ @return The frame
+ */
++ (NSData *)rawFrameForSample:(int32_t)sample;
+
+/**
+ @brief Does a payload look like a sample frame?
+
+ @param bytes The payload
+ @param length The payload length
+ @return YES if the payload starts with a sample frame marker
+ */
++ (BOOL)isSampleFrame:(const uint8_t *)bytes
+               length:(NSUInteger)length;
+
+/**
+ @brief Decode a frame
+
+ Delta frames that do not follow on from the last decoded frame are skipped until the next keyframe.
+
+ @param bytes The frame
+ @param length The frame length
+ @param samples Buffer to receive the samples
+ @param capacity The number of samples the buffer can hold
+ @return The number of samples decoded, 0 if the frame was skipped, or -1 if it is malformed
+ */
+- (NSInteger)decodeFrame:(const uint8_t *)bytes
+                  length:(NSUInteger)length
+             intoSamples:(int32_t *)samples
+                capacity:(NSUInteger)capacity;
+
+@end
+
+/** @} */
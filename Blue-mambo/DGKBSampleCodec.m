@@ -0,0 +1,285 @@
+//
+//  DGKBSampleCodec.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSampleCodec.h"
+
+/**
+ @def DGKBSampleHeaderLength
+ @brief The length of a batched frame header: marker, sequence number and a one byte sample count
+ */
+#define DGKBSampleHeaderLength 3
+/**
+ @def DGKBVarintMaxLength
+ @brief The longest varint encoding of a 32 bit value
+ */
+#define DGKBVarintMaxLength 5
+
+/**
+ @brief Zigzag encode a signed value, so that small negative numbers stay small
+ @param value The value
+ @return The encoded value
+ */
+static inline uint32_t DGKBZigzagEncode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/**
+ @brief Zigzag decode a value
+ @param value The encoded value
+ @return The signed value
+ */
+static inline int32_t DGKBZigzagDecode(uint32_t value)
+{
+    return (int32_t)((value >> 1) ^ (0 - (value & 1)));
+}
+
+/**
+ @brief Write a varint, seven bits per byte with the top bit set on all but the last byte
+ @param value The value
+ @param bytes Buffer of at least DGKBVarintMaxLength bytes
+ @return The number of bytes written
+ */
+static inline NSUInteger DGKBVarintWrite(uint32_t value, uint8_t *bytes)
+{
+    NSUInteger length = 0;
+    while (value >= 0x80)
+    {
+        bytes[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (uint8_t)value;
+    return length;
+}
+
+/**
+ @brief Read a varint
+ @param bytes The buffer
+ @param length The buffer length
+ @param offset The offset to read from, advanced past the varint
+ @param value Receives the value
+ @return NO if the varint runs off the end of the buffer or is too long
+ */
+static inline BOOL DGKBVarintRead(const uint8_t *bytes, NSUInteger length, NSUInteger *offset, uint32_t *value)
+{
+    uint32_t result = 0;
+    for (NSUInteger index = 0; index < DGKBVarintMaxLength; index++)
+    {
+        if (*offset >= length) return NO;
+        uint8_t byte = bytes[(*offset)++];
+        result |= (uint32_t)(byte & 0x7F) << (7 * index);
+        if ((byte & 0x80) == 0)
+        {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+/**
+ @extends DGKBSampleCodec
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Delta/varint sample codec extension
+
+ Internal functionality for the sample codec. Private extensions to DGKBSampleCodec @see DGKBSampleCodec
+ */
+@interface DGKBSampleCodec ()
+{
+    uint8_t _body[DGKBSampleCodecMaxFrameLength];   ///< The encoded samples in the current frame
+}
+
+@property (nonatomic, assign) NSUInteger frameLength;           ///< The largest frame to build
+@property (nonatomic, assign) NSUInteger keyframeInterval;      ///< How often, in frames, to send a keyframe
+@property (nonatomic, assign) NSUInteger bodyLength;            ///< The number of bytes in the current frame's body
+@property (nonatomic, assign) NSUInteger sampleCount;           ///< The number of samples in the current frame
+@property (nonatomic, assign) NSUInteger framesSinceKeyframe;   ///< The number of frames since the last keyframe
+@property (nonatomic, assign) uint8_t sequence;                 ///< The next frame's sequence number
+@property (nonatomic, assign) int32_t lastEncoded;              ///< The last sample encoded
+@property (nonatomic, assign) BOOL decodeInSync;                ///< Has a keyframe been decoded since the last gap?
+@property (nonatomic, assign) uint8_t expectedSequence;         ///< The sequence number the next decoded frame should have
+@property (nonatomic, assign) int32_t lastDecoded;              ///< The last sample decoded
+
+/**
+ @brief Encode a sample as it would appear next in the current frame
+ @param sample The sample
+ @param bytes Buffer of at least DGKBVarintMaxLength bytes
+ @return The number of bytes written
+ */
+- (NSUInteger)encodeSample:(int32_t)sample
+                      into:(uint8_t *)bytes;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBSampleCodec
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBSampleCodec
+
+- (id)initWithFrameLength:(NSUInteger)frameLength
+         keyframeInterval:(NSUInteger)keyframeInterval
+{
+    self = [super init];
+    if (self)
+    {
+        _frameLength = MAX(DGKBSampleHeaderLength + DGKBVarintMaxLength, MIN(frameLength, DGKBSampleCodecMaxFrameLength));
+        _keyframeInterval = MAX(1, keyframeInterval);
+    }
+    return self;
+}
+
+/**
+ - The first sample of a keyframe is absolute, every other sample is the difference from the one before it
+ - The difference wraps like the samples do, so the decoder's addition wraps back to the same value
+ */
+- (NSUInteger)encodeSample:(int32_t)sample
+                      into:(uint8_t *)bytes
+{
+    BOOL absolute = _sampleCount == 0 && _framesSinceKeyframe == 0;
+    int32_t value = absolute ? sample : (int32_t)((uint32_t)sample - (uint32_t)_lastEncoded);
+    return DGKBVarintWrite(DGKBZigzagEncode(value), bytes);
+}
+
+/**
+ - Encode the sample against the current frame
+ - If it does not fit, finish the current frame and encode it again against the next one
+ - Append it to the frame body
+ */
+- (NSData *)addSample:(int32_t)sample
+{
+    NSData *frame = nil;
+    uint8_t encoded[DGKBVarintMaxLength];
+    NSUInteger length = [self encodeSample:sample
+                                      into:encoded];
+    if (_sampleCount > 0 &&
+        (DGKBSampleHeaderLength + _bodyLength + length > _frameLength || _sampleCount == DGKBSampleMaxPerFrame))
+    {
+        frame = [self flush];
+        length = [self encodeSample:sample
+                               into:encoded];
+    }
+    memcpy(_body + _bodyLength, encoded, length);
+    _bodyLength += length;
+    _sampleCount++;
+    _lastEncoded = sample;
+    return frame;
+}
+
+- (NSData *)flush
+{
+    if (_sampleCount == 0) return nil;
+
+    NSMutableData *frame = [NSMutableData dataWithCapacity:DGKBSampleHeaderLength + _bodyLength];
+    uint8_t header[DGKBSampleHeaderLength];
+    header[0] = _framesSinceKeyframe == 0 ? DGKBSampleKeyframeMarker : DGKBSampleDeltaMarker;
+    header[1] = _sequence++;
+    header[2] = (uint8_t)_sampleCount;
+    [frame appendBytes:header length:DGKBSampleHeaderLength];
+    [frame appendBytes:_body length:_bodyLength];
+
+    _framesSinceKeyframe = (_framesSinceKeyframe + 1) % _keyframeInterval;
+    _sampleCount = 0;
+    _bodyLength = 0;
+    return frame;
+}
+
+/**
+ - A keyframe already in progress will do
+ - A delta frame already in progress is finished as it is, and the keyframe starts with the frame after it
+ */
+- (void)requestKeyframe
+{
+    if (_framesSinceKeyframe == 0) return;
+    _framesSinceKeyframe = _sampleCount > 0 ? _keyframeInterval - 1 : 0;
+}
+
++ (NSData *)rawFrameForSample:(int32_t)sample
+{
+    uint8_t bytes[5];
+    bytes[0] = DGKBSampleRawMarker;
+    uint32_t value = CFSwapInt32HostToLittle((uint32_t)sample);
+    memcpy(bytes + 1, &value, sizeof(value));
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
++ (BOOL)isSampleFrame:(const uint8_t *)bytes
+               length:(NSUInteger)length
+{
+    if (length == 0) return NO;
+    return bytes[0] == DGKBSampleRawMarker || bytes[0] == DGKBSampleDeltaMarker || bytes[0] == DGKBSampleKeyframeMarker;
+}
+
+/**
+ - Raw frames hold a single little-endian sample and do not affect the batched stream
+ - A delta frame is skipped if no keyframe has been decoded yet or a frame has been missed
+ - A malformed frame also loses sync, so nothing is decoded against a bad value
+ - Nothing is allocated; samples go straight into the caller's buffer
+ */
+- (NSInteger)decodeFrame:(const uint8_t *)bytes
+                  length:(NSUInteger)length
+             intoSamples:(int32_t *)samples
+                capacity:(NSUInteger)capacity
+{
+    if (![DGKBSampleCodec isSampleFrame:bytes length:length]) return -1;
+
+    if (bytes[0] == DGKBSampleRawMarker)
+    {
+        if (length != 5 || capacity < 1) return -1;
+        uint32_t value;
+        memcpy(&value, bytes + 1, sizeof(value));
+        samples[0] = (int32_t)CFSwapInt32LittleToHost(value);
+        return 1;
+    }
+
+    BOOL keyframe = bytes[0] == DGKBSampleKeyframeMarker;
+    NSUInteger offset = 1;
+    if (length < DGKBSampleHeaderLength) return -1;
+    uint8_t sequence = bytes[offset++];
+    if (!keyframe && (!_decodeInSync || sequence != _expectedSequence))
+    {
+        _decodeInSync = NO;
+        return 0;
+    }
+
+    uint32_t count;
+    if (!DGKBVarintRead(bytes, length, &offset, &count) || count > capacity)
+    {
+        _decodeInSync = NO;
+        return -1;
+    }
+
+    uint32_t previous = (uint32_t)_lastDecoded;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        uint32_t encoded;
+        if (!DGKBVarintRead(bytes, length, &offset, &encoded))
+        {
+            _decodeInSync = NO;
+            return -1;
+        }
+        int32_t value = DGKBZigzagDecode(encoded);
+        previous = (keyframe && index == 0) ? (uint32_t)value : previous + (uint32_t)value;
+        samples[index] = (int32_t)previous;
+    }
+
+    _lastDecoded = (int32_t)previous;
+    _expectedSequence = (uint8_t)(sequence + 1);
+    _decodeInSync = YES;
+    return count;
+}
+
+@end
+
+/** @} */
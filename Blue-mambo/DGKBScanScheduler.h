@@ -0,0 +1,74 @@
+//
+//  DGKBScanScheduler.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @interface DGKBScanScheduler
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Scan duty cycle scheduler
+
+ Decides how long each scan window lasts and how long to pause before the next one (the
+ interval runs from window start to window start). Every window that ends without finding a
+ peripheral doubles the pause, up to maximumPause, and each pause is jittered by up to 25%
+ either way so that several listeners do not fall into step. Finding a peripheral, or starting
+ a new scan, returns to the normal pause.
+ */
+@interface DGKBScanScheduler : NSObject
+
+/// The longest pause between scan windows, before jitter (60 seconds unless set)
+@property (nonatomic, assign) NSTimeInterval maximumPause;
+
+/// The number of scan windows in a row that found nothing
+@property (nonatomic, readonly) NSUInteger consecutiveMisses;
+
+/**
+ @brief Initialise a scheduler
+
+ A window as long as its interval means scan continuously
+
+ @param window How long each scan window lasts
+ @param interval The time from one scan window to the next
+ @return The scheduler
+ */
+- (id)initWithWindow:(NSTimeInterval)window
+            interval:(NSTimeInterval)interval;
+
+/**
+ @brief Get the length of the next scan window
+ @return The window, or a negative value to scan continuously
+ */
+- (NSTimeInterval)scanWindow;
+
+/**
+ @brief Get the length of the next pause, with backoff and jitter applied
+ @return The pause
+ */
+- (NSTimeInterval)nextPause;
+
+/**
+ @brief A scan window ended without finding anything
+ */
+- (void)didMiss;
+
+/**
+ @brief A peripheral was found
+ */
+- (void)didFind;
+
+/**
+ @brief A new scan is starting; forget the misses of earlier scans
+ */
+- (void)reset;
+
+@end
+
+/** @} */
@@ -0,0 +1,96 @@
+//
+//  DGKBScanScheduler.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBScanScheduler.h"
+
+/**
+ @def DGKBScanJitter
+ @brief The most a pause is lengthened or shortened by, as a fraction of the pause
+ */
+#define DGKBScanJitter 0.25
+/**
+ @def DGKBScanBackoffLimit
+ @brief The most times a pause is doubled, whatever maximumPause is
+ */
+#define DGKBScanBackoffLimit 16
+
+/**
+ @extends DGKBScanScheduler
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Scan duty cycle scheduler extension
+
+ Internal functionality for the scan scheduler. Private extensions to DGKBScanScheduler @see DGKBScanScheduler
+ */
+@interface DGKBScanScheduler ()
+
+@property (nonatomic, assign) NSTimeInterval window;    ///< How long each scan window lasts
+@property (nonatomic, assign) NSTimeInterval interval;  ///< The time from one scan window to the next
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBScanScheduler
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBScanScheduler
+
+- (id)initWithWindow:(NSTimeInterval)window
+            interval:(NSTimeInterval)interval
+{
+    self = [super init];
+    if (self)
+    {
+        _window = window;
+        _interval = MAX(window, interval);
+        _maximumPause = 60.0;
+    }
+    return self;
+}
+
+- (NSTimeInterval)scanWindow
+{
+    return _window < _interval ? _window : -1.0;
+}
+
+/**
+ - Start from the interval less the window
+ - Double it for every window in a row that found nothing, up to the maximum pause
+ - Lengthen or shorten the result by a random amount up to the jitter fraction
+ */
+- (NSTimeInterval)nextPause
+{
+    NSTimeInterval pause = _interval - _window;
+    pause = MIN(pause * (1 << MIN(_consecutiveMisses, DGKBScanBackoffLimit)), MAX(pause, _maximumPause));
+    double jitter = ((double)arc4random_uniform(2001) / 1000.0 - 1.0) * DGKBScanJitter;
+    return pause * (1.0 + jitter);
+}
+
+- (void)didMiss
+{
+    _consecutiveMisses++;
+}
+
+- (void)didFind
+{
+    _consecutiveMisses = 0;
+}
+
+- (void)reset
+{
+    _consecutiveMisses = 0;
+}
+
+@end
+
+/** @} */
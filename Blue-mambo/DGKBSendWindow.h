@@ -0,0 +1,129 @@
+//
+//  DGKBSendWindow.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @def DGKBAckWindowMax
+ @brief The largest window supported by the acknowledgement bitmap
+ */
+#define DGKBAckWindowMax 32
+
+/**
+ @interface DGKBSendWindow
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Sliding send window
+
+ Sender half of the windowed acknowledgement protocol. Each payload is framed with a 16 bit
+ little-endian sequence number. Up to windowSize frames may be unacknowledged at once; frames
+ that are not acknowledged within the retransmit timeout are offered again by nextFrame.
+
+ Acknowledgement packets are 6 bytes: the receiver's next expected sequence number (uint16)
+ followed by a bitmap (uint32) of the frames after it that have already arrived.
+
+ Send times are taken from the system uptime, so a change to the wall clock cannot fire or hold
+ back retransmissions.
+ @see DGKBReceiveWindow
+ */
+@interface DGKBSendWindow : NSObject
+
+/// The maximum number of unacknowledged frames
+@property (nonatomic, readonly) NSUInteger windowSize;
+
+/// How long a frame may go unacknowledged before it is resent
+@property (nonatomic, readonly) NSTimeInterval retransmitTimeout;
+
+/// The number of payloads waiting for space in the window
+@property (nonatomic, readonly) NSUInteger backlogCount;
+
+/// The number of frames sent but not yet acknowledged
+@property (nonatomic, readonly) NSUInteger inFlightCount;
+
+/// The number of frames that have been resent
+@property (nonatomic, readonly) NSUInteger retransmitCount;
+
+/// The number of frames that have been acknowledged
+@property (nonatomic, readonly) NSUInteger acknowledgedCount;
+
+/// The number of payloads discarded because the backlog was full
+@property (nonatomic, readonly) NSUInteger droppedCount;
+
+/// When the last acknowledgement that advanced the window arrived, as system uptime (0 if none has)
+@property (nonatomic, readonly) NSTimeInterval lastAckTime;
+
+/// The maximum number of backlogged payloads, the oldest are discarded beyond this (0 for no limit)
+@property (nonatomic, assign) NSUInteger backlogLimit;
+
+/**
+ @brief Initialise a send window
+
+ @param windowSize The maximum number of unacknowledged frames (clamped to DGKBAckWindowMax)
+ @param seconds How long to wait for an acknowledgement before resending a frame
+ @return The send window
+ */
+- (id)initWithWindowSize:(NSUInteger)windowSize
+       retransmitTimeout:(NSTimeInterval)seconds;
+
+/**
+ @brief Queue a payload for sending
+
+ If the backlog is full the oldest backlogged payload is discarded
+
+ @param payload The payload
+ */
+- (void)enqueuePayload:(NSData *)payload;
+
+/**
+ @brief Get the next frame that should be sent
+
+ Frames due for retransmission are offered first, then new frames while the window has room.
+ The same frame is offered again until didSendFrame is called.
+
+ @return The frame, or nil if there is nothing to send right now
+ */
+- (NSData *)nextFrame;
+
+/**
+ @brief Record that the frame returned by the last call to nextFrame was sent
+ */
+- (void)didSendFrame;
+
+/**
+ @brief Process an acknowledgement packet from the receiver
+
+ @param ack The acknowledgement packet
+ */
+- (void)processAck:(NSData *)ack;
+
+/**
+ @brief Get the time until the oldest unacknowledged frame is due for retransmission
+
+ @return The number of seconds, or a negative value if nothing is in flight
+ */
+- (NSTimeInterval)timeUntilNextRetransmit;
+
+/**
+ @brief Discard all queued and in flight frames and restart the sequence
+ */
+- (void)reset;
+
+/**
+ @brief Read the clock that send and acknowledgement times are taken from
+
+ Subclasses may override this to run the window on a simulated clock
+
+ @return The system uptime
+ */
+- (NSTimeInterval)currentTime;
+
+@end
+
+/** @} */
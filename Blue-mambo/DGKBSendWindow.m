@@ -0,0 +1,236 @@
+//
+//  DGKBSendWindow.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSendWindow.h"
+
+/**
+ @def DGKBAckPacketLength
+ @brief The length of an acknowledgement packet
+ */
+#define DGKBAckPacketLength 6
+
+/**
+ @def DGKBSlot
+ @brief Maps a sequence number to its slot in the window
+ */
+#define DGKBSlot(sequence) ((sequence) & (DGKBAckWindowMax - 1))
+
+/**
+ @extends DGKBSendWindow
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Sliding send window extension
+
+ Internal functionality for the send window. Private extensions to DGKBSendWindow @see DGKBSendWindow
+ */
+@interface DGKBSendWindow ()
+{
+    NSTimeInterval _sentAt[DGKBAckWindowMax];   ///< When each in flight frame was last sent, as system uptime (0 if not yet sent)
+    BOOL _acked[DGKBAckWindowMax];              ///< Has each in flight frame been selectively acknowledged?
+}
+
+@property (nonatomic, strong) NSMutableArray *backlog;  ///< Payloads waiting for space in the window
+@property (nonatomic, strong) NSMutableArray *frames;   ///< In flight frames, indexed by slot
+@property (nonatomic, assign) uint16_t base;            ///< The oldest unacknowledged sequence number
+@property (nonatomic, assign) uint16_t next;            ///< The next sequence number to assign
+@property (nonatomic, assign) uint16_t offered;         ///< The sequence number last returned by nextFrame
+@property (nonatomic, assign) BOOL hasOffered;          ///< Is there an offered frame waiting for didSendFrame?
+
+/**
+ @brief Move backlogged payloads into the window while there is room
+ */
+- (void)admitBacklog;
+
+/**
+ @brief Release acknowledged frames from the front of the window
+ */
+- (void)slideWindow;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBSendWindow
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBSendWindow
+
+- (id)initWithWindowSize:(NSUInteger)windowSize
+       retransmitTimeout:(NSTimeInterval)seconds
+{
+    self = [super init];
+    if (self)
+    {
+        _windowSize = MAX(1, MIN(windowSize, DGKBAckWindowMax));
+        _retransmitTimeout = seconds;
+        _backlog = [NSMutableArray array];
+        _frames = [NSMutableArray arrayWithCapacity:DGKBAckWindowMax];
+        for (NSUInteger slot = 0; slot < DGKBAckWindowMax; slot++)
+        {
+            [_frames addObject:[NSNull null]];
+        }
+    }
+    return self;
+}
+
+- (NSUInteger)backlogCount
+{
+    return _backlog.count;
+}
+
+- (NSUInteger)inFlightCount
+{
+    return (uint16_t)(_next - _base);
+}
+
+- (void)enqueuePayload:(NSData *)payload
+{
+    [_backlog addObject:payload];
+    if (_backlogLimit > 0 && _backlog.count > _backlogLimit)
+    {
+        [_backlog removeObjectAtIndex:0];
+        _droppedCount++;
+    }
+}
+
+/**
+ - Admit backlogged payloads into the window
+ - Offer the oldest frame that has never been sent or whose acknowledgement is overdue
+ */
+- (NSData *)nextFrame
+{
+    [self admitBacklog];
+
+    NSTimeInterval now = [self currentTime];
+    for (uint16_t sequence = _base; sequence != _next; sequence++)
+    {
+        NSUInteger slot = DGKBSlot(sequence);
+        if (_acked[slot]) continue;
+        if (_sentAt[slot] == 0 || now - _sentAt[slot] >= _retransmitTimeout)
+        {
+            _offered = sequence;
+            _hasOffered = YES;
+            return _frames[slot];
+        }
+    }
+    _hasOffered = NO;
+    return nil;
+}
+
+- (void)didSendFrame
+{
+    if (!_hasOffered) return;
+    _hasOffered = NO;
+
+    NSUInteger slot = DGKBSlot(_offered);
+    if (_sentAt[slot] != 0) _retransmitCount++;
+    _sentAt[slot] = [self currentTime];
+}
+
+/**
+ - Ignore packets that are malformed or refer to sequence numbers outside the window
+ - Everything before the receiver's next expected sequence number has arrived
+ - Each bit in the bitmap marks one later frame that has arrived
+ - Slide the window past the acknowledged frames
+ */
+- (void)processAck:(NSData *)ack
+{
+    if (ack.length < DGKBAckPacketLength) return;
+
+    const uint8_t *bytes = ack.bytes;
+    uint16_t expected = (uint16_t)(bytes[0] | (bytes[1] << 8));
+    uint32_t bitmap = (uint32_t)bytes[2] | ((uint32_t)bytes[3] << 8) | ((uint32_t)bytes[4] << 16) | ((uint32_t)bytes[5] << 24);
+
+    uint16_t acknowledged = (uint16_t)(expected - _base);
+    if (acknowledged > self.inFlightCount) return;
+
+    for (uint16_t sequence = _base; sequence != expected; sequence++)
+    {
+        _acked[DGKBSlot(sequence)] = YES;
+    }
+    for (NSUInteger bit = 0; bit < DGKBAckWindowMax && bitmap; bit++, bitmap >>= 1)
+    {
+        uint16_t sequence = (uint16_t)(expected + 1 + bit);
+        if ((uint16_t)(sequence - _base) >= self.inFlightCount) break;
+        if (bitmap & 1) _acked[DGKBSlot(sequence)] = YES;
+    }
+    [self slideWindow];
+}
+
+- (NSTimeInterval)timeUntilNextRetransmit
+{
+    NSTimeInterval oldest = 0;
+    for (uint16_t sequence = _base; sequence != _next; sequence++)
+    {
+        NSUInteger slot = DGKBSlot(sequence);
+        if (_acked[slot] || _sentAt[slot] == 0) continue;
+        if (oldest == 0 || _sentAt[slot] < oldest) oldest = _sentAt[slot];
+    }
+    if (oldest == 0) return -1;
+    return MAX(0, oldest + _retransmitTimeout - [self currentTime]);
+}
+
+- (NSTimeInterval)currentTime
+{
+    return [[NSProcessInfo processInfo] systemUptime];
+}
+
+- (void)reset
+{
+    [_backlog removeAllObjects];
+    for (NSUInteger slot = 0; slot < DGKBAckWindowMax; slot++)
+    {
+        _frames[slot] = [NSNull null];
+        _sentAt[slot] = 0;
+        _acked[slot] = NO;
+    }
+    _base = 0;
+    _next = 0;
+    _hasOffered = NO;
+}
+
+- (void)admitBacklog
+{
+    while (_backlog.count > 0 && self.inFlightCount < _windowSize)
+    {
+        NSData *payload = _backlog[0];
+        [_backlog removeObjectAtIndex:0];
+
+        uint8_t header[2] = { (uint8_t)(_next & 0xff), (uint8_t)(_next >> 8) };
+        NSMutableData *frame = [NSMutableData dataWithBytes:header length:sizeof(header)];
+        [frame appendData:payload];
+
+        NSUInteger slot = DGKBSlot(_next);
+        _frames[slot] = frame;
+        _sentAt[slot] = 0;
+        _acked[slot] = NO;
+        _next++;
+    }
+}
+
+- (void)slideWindow
+{
+    while (_base != _next && _acked[DGKBSlot(_base)])
+    {
+        NSUInteger slot = DGKBSlot(_base);
+        _frames[slot] = [NSNull null];
+        _sentAt[slot] = 0;
+        _acked[slot] = NO;
+        _base++;
+        _acknowledgedCount++;
+        _lastAckTime = [self currentTime];
+    }
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,62 @@
+//
+//  DGKBSnapshotChannel.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @addtogroup Types
+ @{
+ */
+
+/**
+ @typedef DGKBSnapshotConsumerBlockType
+ @brief Snapshot consumer code block
+
+ A new snapshot is ready; executed on the main thread
+
+ @param snapshot The latest snapshot
+ */
+typedef void(^DGKBSnapshotConsumerBlockType)(id snapshot);
+
+/** @} */
+
+/**
+ @interface DGKBSnapshotChannel
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Latest value channel to the main thread
+
+ Hands immutable snapshots from one producer (the processing queue) to the main thread without
+ taking a lock. The channel holds only the latest snapshot: publishing swaps it into a mailbox
+ with an atomic compare and swap, and a newer snapshot replaces one the main thread has not
+ taken yet. An atomic flag makes sure at most one drain is waiting on the main queue, so however
+ fast snapshots are published the main thread applies at most one per turn of its run loop.
+ */
+@interface DGKBSnapshotChannel : NSObject
+
+/**
+ @brief Initialise a channel
+ @param block The block to execute on the main thread with each snapshot taken from the channel
+ @return The channel
+ */
+- (id)initWithConsumer:(DGKBSnapshotConsumerBlockType)block;
+
+/**
+ @brief Publish a snapshot
+
+ The snapshot must not change after it is published
+
+ @param snapshot The snapshot
+ */
+- (void)publish:(id)snapshot;
+
+@end
+
+/** @} */
@@ -0,0 +1,109 @@
+//
+//  DGKBSnapshotChannel.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSnapshotChannel.h"
+#import <libkern/OSAtomic.h>
+
+/**
+ @extends DGKBSnapshotChannel
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Latest value channel extension
+
+ Internal functionality for the snapshot channel. Private extensions to DGKBSnapshotChannel @see DGKBSnapshotChannel
+ */
+@interface DGKBSnapshotChannel ()
+{
+    void * volatile _mailbox;           ///< The latest snapshot not yet taken, retained (NULL if none)
+    volatile int32_t _drainScheduled;   ///< Is a drain waiting on the main queue?
+}
+
+@property (nonatomic, copy) DGKBSnapshotConsumerBlockType consumerBlock; ///< The code block that consumes snapshots
+
+/**
+ @brief Swap a value into the mailbox
+ @param value The value to leave in the mailbox, retained, or NULL
+ @return The value that was in the mailbox, still retained, or NULL
+ */
+- (void *)exchangeMailbox:(void *)value;
+
+/**
+ @brief Take the latest snapshot and hand it to the consumer
+ */
+- (void)drain;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBSnapshotChannel
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBSnapshotChannel
+
+- (id)initWithConsumer:(DGKBSnapshotConsumerBlockType)block
+{
+    self = [super init];
+    if (self)
+    {
+        _consumerBlock = block;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    void *snapshot = [self exchangeMailbox:NULL];
+    if (snapshot) CFRelease(snapshot);
+}
+
+- (void *)exchangeMailbox:(void *)value
+{
+    void *previous;
+    do
+    {
+        previous = _mailbox;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(previous, value, &_mailbox));
+    return previous;
+}
+
+/**
+ - Swap the snapshot into the mailbox, releasing one the main thread never took
+ - Schedule a drain unless one is already waiting
+ */
+- (void)publish:(id)snapshot
+{
+    void *replaced = [self exchangeMailbox:(__bridge_retained void *)snapshot];
+    if (replaced) CFRelease(replaced);
+
+    if (!OSAtomicCompareAndSwap32Barrier(0, 1, &_drainScheduled)) return;
+    __weak DGKBSnapshotChannel *weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [weakSelf drain];
+    });
+}
+
+/**
+ - Clear the flag before taking the snapshot, so a snapshot published from here on schedules another drain
+ - Take whatever is in the mailbox and hand it to the consumer
+ */
+- (void)drain
+{
+    OSAtomicCompareAndSwap32Barrier(1, 0, &_drainScheduled);
+    void *snapshot = [self exchangeMailbox:NULL];
+    if (!snapshot) return;
+    _consumerBlock((__bridge_transfer id)snapshot);
+}
+
+@end
+
+/** @} */
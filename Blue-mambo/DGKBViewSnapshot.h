@@ -0,0 +1,116 @@
+//
+//  DGKBViewSnapshot.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @def DGKBViewSnapshotLogLineLimit
+ @brief The number of lines the log report keeps; the oldest are discarded beyond this
+ */
+#define DGKBViewSnapshotLogLineLimit 100
+
+/**
+ @interface DGKBViewSnapshot
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Bluetooth screen view model snapshot
+
+ Everything a Bluetooth screen shows, captured at one moment on the processing queue. A
+ snapshot never changes once made, so it can be handed to the main thread as it is. Rather
+ than asking for an animation, the processing queue bumps a pulse count; the screen runs the
+ animation once for however many pulses arrived since the last snapshot it applied.
+ @see DGKBMutableViewSnapshot
+ */
+@interface DGKBViewSnapshot : NSObject <NSCopying, NSMutableCopying>
+
+/// The status message
+@property (nonatomic, readonly, copy) NSString *statusText;
+
+/// The colour to display the status message
+@property (nonatomic, readonly, strong) UIColor *statusColour;
+
+/// The Bluetooth manager's state
+@property (nonatomic, readonly, copy) NSString *bluetoothStatus;
+
+/// The log report
+@property (nonatomic, readonly, copy) NSString *logText;
+
+/// Is scanning in progress?
+@property (nonatomic, readonly) BOOL scanning;
+
+/// Is a peer connected?
+@property (nonatomic, readonly) BOOL connected;
+
+/// The number of times a peer has connected
+@property (nonatomic, readonly) NSUInteger connectPulseCount;
+
+/// The number of times a peer has disconnected
+@property (nonatomic, readonly) NSUInteger disconnectPulseCount;
+
+/// When the callback for the latest value shown arrived, from DGKBPipelineTrace's clock (0 if no value has arrived)
+@property (nonatomic, readonly) int64_t valueTimestamp;
+
+@end
+
+/** @} */
+
+/**
+ @interface DGKBMutableViewSnapshot
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief Bluetooth screen view model
+
+ The view model that the processing queue keeps up to date. Copy it to take a snapshot.
+ @see DGKBViewSnapshot
+ */
+@interface DGKBMutableViewSnapshot : DGKBViewSnapshot
+
+/// The status message
+@property (nonatomic, readwrite, copy) NSString *statusText;
+
+/// The colour to display the status message
+@property (nonatomic, readwrite, strong) UIColor *statusColour;
+
+/// The Bluetooth manager's state
+@property (nonatomic, readwrite, copy) NSString *bluetoothStatus;
+
+/// The log report
+@property (nonatomic, readwrite, copy) NSString *logText;
+
+/// Is scanning in progress?
+@property (nonatomic, readwrite) BOOL scanning;
+
+/// Is a peer connected?
+@property (nonatomic, readwrite) BOOL connected;
+
+/// When the callback for the latest value shown arrived, from DGKBPipelineTrace's clock (0 if no value has arrived)
+@property (nonatomic, readwrite) int64_t valueTimestamp;
+
+/**
+ @brief Add a line to the log report, discarding the oldest once there are more than DGKBViewSnapshotLogLineLimit
+ @param line The line
+ */
+- (void)appendLogLine:(NSString *)line;
+
+/**
+ @brief Ask the screen to show a connection
+ */
+- (void)pulseConnect;
+
+/**
+ @brief Ask the screen to show a disconnection
+ */
+- (void)pulseDisconnect;
+
+@end
+
+/** @} */
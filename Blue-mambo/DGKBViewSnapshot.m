@@ -0,0 +1,176 @@
+//
+//  DGKBViewSnapshot.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBViewSnapshot.h"
+
+/**
+ @extends DGKBViewSnapshot
+ @addtogroup Classes
+ @{
+ */
+/**
+ @brief View model snapshot extension
+
+ Internal functionality for view model snapshots. Private extensions to DGKBViewSnapshot @see DGKBViewSnapshot
+ */
+@interface DGKBViewSnapshot ()
+{
+@protected
+    NSString *_statusText;              ///< The status message
+    UIColor *_statusColour;             ///< The colour to display the status message
+    NSString *_bluetoothStatus;         ///< The Bluetooth manager's state
+    NSString *_logText;                 ///< The log report
+    NSUInteger _logLineCount;           ///< The number of lines in the log report
+    BOOL _scanning;                     ///< Is scanning in progress?
+    BOOL _connected;                    ///< Is a peer connected?
+    NSUInteger _connectPulseCount;      ///< The number of times a peer has connected
+    NSUInteger _disconnectPulseCount;   ///< The number of times a peer has disconnected
+    int64_t _valueTimestamp;            ///< When the callback for the latest value shown arrived
+}
+
+/**
+ @brief Copy every value into a new snapshot
+ @param snapshotClass The class of snapshot to make
+ @return The snapshot
+ */
+- (id)copyAsClass:(Class)snapshotClass;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBViewSnapshot
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBViewSnapshot
+
+- (id)copyAsClass:(Class)snapshotClass
+{
+    DGKBViewSnapshot *copy = [[snapshotClass alloc] init];
+    copy->_statusText = _statusText;
+    copy->_statusColour = _statusColour;
+    copy->_bluetoothStatus = _bluetoothStatus;
+    copy->_logText = _logText;
+    copy->_logLineCount = _logLineCount;
+    copy->_scanning = _scanning;
+    copy->_connected = _connected;
+    copy->_connectPulseCount = _connectPulseCount;
+    copy->_disconnectPulseCount = _disconnectPulseCount;
+    copy->_valueTimestamp = _valueTimestamp;
+    return copy;
+}
+
+/**
+ - A snapshot never changes, so it is its own copy
+ */
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+- (id)mutableCopyWithZone:(NSZone *)zone
+{
+    return [self copyAsClass:[DGKBMutableViewSnapshot class]];
+}
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBMutableViewSnapshot
+ @addtogroup Classes
+ @{
+ */
+@implementation DGKBMutableViewSnapshot
+
+@dynamic statusText;
+@dynamic statusColour;
+@dynamic bluetoothStatus;
+@dynamic logText;
+@dynamic scanning;
+@dynamic connected;
+@dynamic valueTimestamp;
+
+- (void)setStatusText:(NSString *)statusText
+{
+    _statusText = [statusText copy];
+}
+
+- (void)setStatusColour:(UIColor *)statusColour
+{
+    _statusColour = statusColour;
+}
+
+- (void)setBluetoothStatus:(NSString *)bluetoothStatus
+{
+    _bluetoothStatus = [bluetoothStatus copy];
+}
+
+- (void)setLogText:(NSString *)logText
+{
+    _logText = [logText copy];
+    _logLineCount = _logText ? [_logText componentsSeparatedByString:@"\n"].count - 1 : 0;
+}
+
+- (void)setScanning:(BOOL)scanning
+{
+    _scanning = scanning;
+}
+
+- (void)setConnected:(BOOL)connected
+{
+    _connected = connected;
+}
+
+- (void)setValueTimestamp:(int64_t)valueTimestamp
+{
+    _valueTimestamp = valueTimestamp;
+}
+
+/**
+ - Drop the oldest lines until there is room, so the report (and the cost of copying it) stays bounded
+ - Build a new string, so that snapshots already taken keep the text they had
+ */
+- (void)appendLogLine:(NSString *)line
+{
+    NSString *text = _logText ? _logText : @"";
+    while (_logLineCount >= DGKBViewSnapshotLogLineLimit)
+    {
+        NSRange end = [text rangeOfString:@"\n"];
+        if (end.location == NSNotFound) break;
+        text = [text substringFromIndex:NSMaxRange(end)];
+        _logLineCount--;
+    }
+    _logText = [NSString stringWithFormat:@"%@%@\n", text, line];
+    _logLineCount++;
+}
+
+- (void)pulseConnect
+{
+    _connectPulseCount++;
+}
+
+- (void)pulseDisconnect
+{
+    _disconnectPulseCount++;
+}
+
+/**
+ - Copy the values into an immutable snapshot
+ */
+- (id)copyWithZone:(NSZone *)zone
+{
+    return [self copyAsClass:[DGKBViewSnapshot class]];
+}
+
+@end
+
+/** @} */
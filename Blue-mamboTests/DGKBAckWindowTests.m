@@ -0,0 +1,359 @@
+//
+//  DGKBAckWindowTests.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "BlueCommon.h"
+#import "DGKBSendWindow.h"
+#import "DGKBReceiveWindow.h"
+#import "DGKBSimulatedSendWindow.h"
+#import "DGKBLossyLink.h"
+
+/**
+ @defgroup Tests Unit tests
+ @{
+ */
+
+/**
+ @def DGKBTestConnectionInterval
+ @brief Defines the simulated connection interval; the link carries frames once per interval
+ */
+#define DGKBTestConnectionInterval 0.03
+/**
+ @def DGKBTestFramesPerInterval
+ @brief Defines how many notifications the simulated link carries per connection interval
+ */
+#define DGKBTestFramesPerInterval 4
+/**
+ @def DGKBTestPayloadLength
+ @brief Defines the payload length; a full sample frame, as the broadcaster sends
+ */
+#define DGKBTestPayloadLength SAMPLEFRAMELENGTH
+/**
+ @def DGKBTestStartTime
+ @brief Defines when the simulated clock starts; the send window treats a send time of 0 as never sent
+ */
+#define DGKBTestStartTime 1.0
+
+/**
+ @brief The outcome of a simulated transfer
+ */
+typedef struct
+{
+    NSTimeInterval elapsed;     ///< Simulated seconds until the last payload was delivered
+    NSUInteger framesSent;      ///< Frames put on the data link, including resends
+    NSUInteger framesLost;      ///< Frames the data link lost
+    NSUInteger retransmitted;   ///< Frames the send window resent
+    NSUInteger acksSent;        ///< Acknowledgement packets put on the ack link
+} DGKBTransferResult;
+
+/**
+ @brief Windowed acknowledgement protocol tests
+
+ Drives a send window and a receive window against each other over a pair of simulated lossy
+ links: one for notifications, one for the acknowledgements written back. The receiver
+ acknowledges the way the listener does, as soon as half the window is unacknowledged or
+ ACKINTERVAL after the first unacknowledged frame.
+ */
+@interface DGKBAckWindowTests : XCTestCase
+
+/**
+ @brief Make a payload that carries its own index
+ @param index The index
+ @return The payload, DGKBTestPayloadLength bytes long
+ */
+- (NSData *)payloadWithIndex:(uint32_t)index;
+
+/**
+ @brief Read the index a payload carries
+ @param payload The payload
+ @return The index
+ */
+- (uint32_t)indexOfPayload:(NSData *)payload;
+
+/**
+ @brief Transfer payloads over simulated lossy links
+
+ @param count The number of payloads
+ @param dataLoss The share of notifications lost
+ @param ackLoss The share of acknowledgements lost
+ @param seed Seeds which packets are lost
+ @param delivered Collects the delivered payloads, in delivery order
+ @return The outcome
+ */
+- (DGKBTransferResult)transferPayloads:(NSUInteger)count
+                              dataLoss:(double)dataLoss
+                               ackLoss:(double)ackLoss
+                                  seed:(uint32_t)seed
+                             delivered:(NSMutableArray *)delivered;
+
+/**
+ @brief Check that payloads were delivered exactly once each, in order
+ @param delivered The delivered payloads
+ @param count The number of payloads sent
+ */
+- (void)assertDelivered:(NSArray *)delivered
+                inOrder:(NSUInteger)count;
+
+@end
+
+@implementation DGKBAckWindowTests
+
+- (NSData *)payloadWithIndex:(uint32_t)index
+{
+    uint8_t bytes[DGKBTestPayloadLength] = {0};
+    memcpy(bytes, &index, sizeof(index));
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+- (uint32_t)indexOfPayload:(NSData *)payload
+{
+    uint32_t index = 0;
+    [payload getBytes:&index length:sizeof(index)];
+    return index;
+}
+
+/**
+ - Each connection interval: take arrived acknowledgements, send what the window offers, take arrived frames
+ - Acknowledge as the listener does: at half a window, or ACKINTERVAL after the first unacknowledged frame
+ - Stop once every payload is delivered, or give up long after a healthy link would have finished
+ */
+- (DGKBTransferResult)transferPayloads:(NSUInteger)count
+                              dataLoss:(double)dataLoss
+                               ackLoss:(double)ackLoss
+                                  seed:(uint32_t)seed
+                             delivered:(NSMutableArray *)delivered
+{
+    DGKBSimulatedSendWindow *sender = [[DGKBSimulatedSendWindow alloc] initWithWindowSize:ACKWINDOWSIZE
+                                                                        retransmitTimeout:RETRANSMITTIMEOUT];
+    DGKBReceiveWindow *receiver = [[DGKBReceiveWindow alloc] initWithWindowSize:ACKWINDOWSIZE];
+    DGKBLossyLink *dataLink = [[DGKBLossyLink alloc] initWithLossRate:dataLoss
+                                                              latency:DGKBTestConnectionInterval
+                                                                 seed:seed];
+    DGKBLossyLink *ackLink = [[DGKBLossyLink alloc] initWithLossRate:ackLoss
+                                                             latency:DGKBTestConnectionInterval
+                                                                seed:seed * 7919 + 1];
+    for (uint32_t index = 0; index < count; index++)
+    {
+        [sender enqueuePayload:[self payloadWithIndex:index]];
+    }
+
+    NSTimeInterval now = DGKBTestStartTime;
+    NSTimeInterval ackDue = 0;
+    NSUInteger limit = (count + 1) * 1000;
+    for (NSUInteger tick = 0; delivered.count < count && tick < limit; tick++)
+    {
+        now = DGKBTestStartTime + tick * DGKBTestConnectionInterval;
+        sender.simulatedTime = now;
+        for (NSData *ack in [ackLink packetsArrivingBy:now])
+        {
+            [sender processAck:ack];
+        }
+        for (NSUInteger sent = 0; sent < DGKBTestFramesPerInterval; sent++)
+        {
+            NSData *frame = [sender nextFrame];
+            if (!frame) break;
+            [dataLink sendPacket:frame
+                          atTime:now];
+            [sender didSendFrame];
+        }
+        for (NSData *frame in [dataLink packetsArrivingBy:now])
+        {
+            if (receiver.unacknowledgedCount == 0) ackDue = now + ACKINTERVAL;
+            [delivered addObjectsFromArray:[receiver payloadsForFrame:frame]];
+        }
+        if (receiver.unacknowledgedCount > 0 &&
+            (receiver.unacknowledgedCount >= receiver.windowSize / 2 || now >= ackDue))
+        {
+            [ackLink sendPacket:[receiver ackPacket]
+                         atTime:now];
+        }
+    }
+
+    DGKBTransferResult result;
+    result.elapsed = now - DGKBTestStartTime;
+    result.framesSent = dataLink.sentCount;
+    result.framesLost = dataLink.lostCount;
+    result.retransmitted = sender.retransmitCount;
+    result.acksSent = ackLink.sentCount;
+    return result;
+}
+
+- (void)assertDelivered:(NSArray *)delivered
+                inOrder:(NSUInteger)count
+{
+    XCTAssertEqual(delivered.count, count, @"Every payload should be delivered exactly once");
+    for (NSUInteger index = 0; index < delivered.count; index++)
+    {
+        uint32_t carried = [self indexOfPayload:delivered[index]];
+        if (carried != index)
+        {
+            XCTFail(@"Payload %lu delivered in position %lu", (unsigned long)carried, (unsigned long)index);
+            return;
+        }
+    }
+}
+
+#pragma mark - Tests
+
+/**
+ - Losing notifications and acknowledgements both ways must not reorder or lose payloads
+ */
+- (void)testDeliversInOrderOverLossyLink
+{
+    NSMutableArray *delivered = [NSMutableArray array];
+    DGKBTransferResult result = [self transferPayloads:1000
+                                              dataLoss:0.2
+                                               ackLoss:0.2
+                                                  seed:26
+                                             delivered:delivered];
+    [self assertDelivered:delivered
+                  inOrder:1000];
+    XCTAssertTrue(result.framesLost > 0, @"The link should have lost frames");
+}
+
+/**
+ - A frame the receiver already has, or one from before its window, is acknowledged but not delivered again
+ - Lost acknowledgements make the sender resend frames that did arrive; they must still be delivered once
+ */
+- (void)testSuppressesDuplicates
+{
+    DGKBSendWindow *sender = [[DGKBSendWindow alloc] initWithWindowSize:4
+                                                      retransmitTimeout:RETRANSMITTIMEOUT];
+    DGKBReceiveWindow *receiver = [[DGKBReceiveWindow alloc] initWithWindowSize:4];
+    [sender enqueuePayload:[self payloadWithIndex:0]];
+    [sender enqueuePayload:[self payloadWithIndex:1]];
+    NSData *first = [sender nextFrame];
+    [sender didSendFrame];
+    NSData *second = [sender nextFrame];
+    [sender didSendFrame];
+
+    XCTAssertEqual([receiver payloadsForFrame:second].count, (NSUInteger)0, @"An early frame should be held");
+    XCTAssertEqual([receiver payloadsForFrame:second].count, (NSUInteger)0, @"A held frame should not be held twice");
+    XCTAssertEqual([receiver payloadsForFrame:first].count, (NSUInteger)2, @"Filling the gap should deliver both frames");
+    XCTAssertEqual([receiver payloadsForFrame:first].count, (NSUInteger)0, @"A delivered frame should not be delivered again");
+    XCTAssertEqual(receiver.unacknowledgedCount, (NSUInteger)4, @"Duplicates should still be acknowledged");
+
+    NSMutableArray *delivered = [NSMutableArray array];
+    DGKBTransferResult result = [self transferPayloads:1000
+                                              dataLoss:0.0
+                                               ackLoss:0.5
+                                                  seed:27
+                                             delivered:delivered];
+    [self assertDelivered:delivered
+                  inOrder:1000];
+    XCTAssertTrue(result.retransmitted > 0, @"Lost acknowledgements should have caused resends");
+}
+
+/**
+ - Sequence numbers are 16 bits; a transfer longer than that must carry on across the wrap
+ */
+- (void)testSequenceWrapsAround
+{
+    NSUInteger count = 0x10000 + 2 * ACKWINDOWSIZE;
+    NSMutableArray *delivered = [NSMutableArray arrayWithCapacity:count];
+    [self transferPayloads:count
+                  dataLoss:0.02
+                   ackLoss:0.02
+                      seed:28
+                 delivered:delivered];
+    [self assertDelivered:delivered
+                  inOrder:count];
+}
+
+/**
+ - Nothing is resent before the retransmit timeout
+ - Once it passes, only the frame that was not acknowledged is resent, and it is counted once
+ - Every lost frame in a lossy transfer must have been resent
+ */
+- (void)testCountsRetransmissions
+{
+    DGKBSimulatedSendWindow *sender = [[DGKBSimulatedSendWindow alloc] initWithWindowSize:4
+                                                                        retransmitTimeout:RETRANSMITTIMEOUT];
+    DGKBReceiveWindow *receiver = [[DGKBReceiveWindow alloc] initWithWindowSize:4];
+    sender.simulatedTime = DGKBTestStartTime;
+    NSMutableArray *frames = [NSMutableArray array];
+    for (uint32_t index = 0; index < 3; index++)
+    {
+        [sender enqueuePayload:[self payloadWithIndex:index]];
+        [frames addObject:[sender nextFrame]];
+        [sender didSendFrame];
+    }
+    [receiver payloadsForFrame:frames[0]];
+    [receiver payloadsForFrame:frames[2]];
+    [sender processAck:[receiver ackPacket]];
+    XCTAssertEqual(sender.inFlightCount, (NSUInteger)2, @"Only the first frame should be released");
+
+    sender.simulatedTime = DGKBTestStartTime + RETRANSMITTIMEOUT / 2;
+    XCTAssertNil([sender nextFrame], @"Nothing should be resent before the timeout");
+
+    sender.simulatedTime = DGKBTestStartTime + RETRANSMITTIMEOUT;
+    NSData *resent = [sender nextFrame];
+    XCTAssertEqualObjects(resent, frames[1], @"Only the missing frame should be resent");
+    [sender didSendFrame];
+    XCTAssertNil([sender nextFrame], @"The selectively acknowledged frame should not be resent");
+    XCTAssertEqual(sender.retransmitCount, (NSUInteger)1, @"One frame should have been resent");
+
+    XCTAssertEqual([receiver payloadsForFrame:resent].count, (NSUInteger)2, @"The resent frame should release the held one");
+    [sender processAck:[receiver ackPacket]];
+    XCTAssertEqual(sender.inFlightCount, (NSUInteger)0, @"Everything should be acknowledged");
+    XCTAssertEqual(sender.acknowledgedCount, (NSUInteger)3, @"Every frame should be counted as acknowledged");
+
+    NSMutableArray *delivered = [NSMutableArray array];
+    DGKBTransferResult result = [self transferPayloads:1000
+                                              dataLoss:0.1
+                                               ackLoss:0.0
+                                                  seed:29
+                                             delivered:delivered];
+    [self assertDelivered:delivered
+                  inOrder:1000];
+    XCTAssertTrue(result.retransmitted >= result.framesLost, @"Every lost frame should have been resent");
+    XCTAssertEqual(result.framesSent, 1000 + result.retransmitted, @"Every send should be a first send or a counted resend");
+}
+
+/**
+ - Transfer the same payloads at increasing loss rates, on both links
+ - Report goodput, resends and acknowledgements per payload, so a change to the window or the
+   acknowledgement policy can be compared against these curves
+ */
+- (void)testReportsThroughputAgainstLoss
+{
+    NSUInteger count = 2000;
+    double lossRates[] = { 0.0, 0.01, 0.02, 0.05, 0.1, 0.2, 0.3 };
+    NSUInteger rateCount = sizeof(lossRates) / sizeof(lossRates[0]);
+    double goodput[sizeof(lossRates) / sizeof(lossRates[0])];
+
+    NSMutableString *report = [NSMutableString stringWithFormat:@"\n%6s %10s %10s %10s %10s\n",
+                               "loss", "B/s", "seconds", "resent/p", "acks/p"];
+    for (NSUInteger rate = 0; rate < rateCount; rate++)
+    {
+        NSMutableArray *delivered = [NSMutableArray arrayWithCapacity:count];
+        DGKBTransferResult result = [self transferPayloads:count
+                                                  dataLoss:lossRates[rate]
+                                                   ackLoss:lossRates[rate]
+                                                      seed:30 + (uint32_t)rate
+                                                 delivered:delivered];
+        [self assertDelivered:delivered
+                      inOrder:count];
+        goodput[rate] = result.elapsed > 0 ? count * DGKBTestPayloadLength / result.elapsed : 0;
+        [report appendFormat:@"%5.0f%% %10.0f %10.2f %10.3f %10.3f\n",
+         lossRates[rate] * 100.0,
+         goodput[rate],
+         result.elapsed,
+         (double)result.retransmitted / count,
+         (double)result.acksSent / count];
+    }
+    NSLog(@"%@", report);
+
+    double linkRate = DGKBTestFramesPerInterval * DGKBTestPayloadLength / DGKBTestConnectionInterval;
+    XCTAssertTrue(goodput[0] >= linkRate * 0.95, @"A clean link should run at the link rate, less one interval's latency");
+    XCTAssertTrue(goodput[rateCount - 1] < goodput[0], @"Loss should cost throughput");
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,249 @@
+//
+//  DGKBFanoutSchedulerTests.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "BlueCommon.h"
+#import "DGKBSimulatedFanoutScheduler.h"
+#import "DGKBSimulatedCentral.h"
+#import "DGKBLossyLink.h"
+
+/**
+ @addtogroup Tests
+ @{
+ */
+
+/**
+ @def DGKBFanoutTestConnectionInterval
+ @brief Defines the simulated connection interval; 25 BLE units of 1.25 ms, which is exact in binary
+ */
+#define DGKBFanoutTestConnectionInterval 0.03125
+/**
+ @def DGKBFanoutTestPayloadsPerInterval
+ @brief Defines how many payloads the broadcaster queues for every central per connection interval
+ */
+#define DGKBFanoutTestPayloadsPerInterval 2
+/**
+ @def DGKBFanoutTestQueueCapacity
+ @brief Defines how many notifications the transmit queue takes per connection interval, for all centrals together
+ */
+#define DGKBFanoutTestQueueCapacity 16
+/**
+ @def DGKBFanoutTestDuration
+ @brief Defines how many simulated seconds each run lasts
+ */
+#define DGKBFanoutTestDuration 10.0
+/**
+ @def DGKBFanoutTestStartTime
+ @brief Defines when the simulated clock starts; the send window treats a send time of 0 as never sent
+ */
+#define DGKBFanoutTestStartTime 1.0
+/**
+ @def DGKBFanoutTestLateAckLatency
+ @brief Defines how long a late central's acknowledgements take to get back; four retransmit timeouts
+ */
+#define DGKBFanoutTestLateAckLatency (4 * RETRANSMITTIMEOUT)
+/**
+ @def DGKBFanoutTestMaxCentrals
+ @brief Defines the most centrals served at once, counting the slow one
+ */
+#define DGKBFanoutTestMaxCentrals 8
+
+/**
+ @brief How the slow central in a run misbehaves
+ */
+typedef enum
+{
+    DGKBSlowCentralNone = 0,            ///< No slow central: the baseline
+    DGKBSlowCentralNeverAcks,           ///< The slow central never acknowledges anything
+    DGKBSlowCentralAcksLate             ///< The slow central's acknowledgements arrive DGKBFanoutTestLateAckLatency late
+} DGKBSlowCentralType;
+
+/**
+ @brief Fan-out scheduler tests
+
+ Serves several simulated centrals through one fan-out scheduler, sharing a transmit queue that
+ takes DGKBFanoutTestQueueCapacity notifications per connection interval. One central is slow.
+ The fast centrals are compared against a baseline run of the same fast centrals on their own:
+ the slow one must not cost them throughput, and must add no more than one connection interval
+ to their tail latency.
+ */
+@interface DGKBFanoutSchedulerTests : XCTestCase
+
+/**
+ @brief Serve simulated centrals for DGKBFanoutTestDuration
+
+ @param fastCount The number of fast centrals
+ @param slow How the extra slow central misbehaves, or DGKBSlowCentralNone for no slow central
+ @return The centrals, fast ones first and the slow one last
+ */
+- (NSArray *)serveFastCentrals:(NSUInteger)fastCount
+                   slowCentral:(DGKBSlowCentralType)slow;
+
+/**
+ @brief Check that a slow central does not hold back fast ones, from 2 to DGKBFanoutTestMaxCentrals centrals
+
+ @param slow How the slow central misbehaves
+ */
+- (void)assertFastCentralsUnaffectedBySlowCentral:(DGKBSlowCentralType)slow;
+
+@end
+
+@implementation DGKBFanoutSchedulerTests
+
+/**
+ - Each connection interval: the centrals take arrived notifications, then the scheduler takes arrived acknowledgements
+ - Queue this interval's payloads for every central, stamped with the time they were queued
+ - Give the scheduler one send opportunity, stopping it once the transmit queue has taken its share
+ */
+- (NSArray *)serveFastCentrals:(NSUInteger)fastCount
+                   slowCentral:(DGKBSlowCentralType)slow
+{
+    NSMutableArray *centrals = [NSMutableArray array];
+    for (NSUInteger index = 0; index < fastCount; index++)
+    {
+        [centrals addObject:[[DGKBSimulatedCentral alloc] initWithName:[NSString stringWithFormat:@"fast%lu", (unsigned long)index]
+                                                           dataLatency:DGKBFanoutTestConnectionInterval
+                                                            ackLatency:DGKBFanoutTestConnectionInterval
+                                                          acknowledges:YES]];
+    }
+    if (slow != DGKBSlowCentralNone)
+    {
+        [centrals addObject:[[DGKBSimulatedCentral alloc] initWithName:@"slow"
+                                                           dataLatency:DGKBFanoutTestConnectionInterval
+                                                            ackLatency:DGKBFanoutTestLateAckLatency
+                                                          acknowledges:(slow == DGKBSlowCentralAcksLate)]];
+    }
+
+    DGKBSimulatedFanoutScheduler *fanout = [[DGKBSimulatedFanoutScheduler alloc] initWithWindowSize:ACKWINDOWSIZE
+                                                                                  retransmitTimeout:RETRANSMITTIMEOUT
+                                                                                            quantum:FANOUTQUANTUM
+                                                                                       backlogLimit:FANOUTBACKLOG];
+    fanout.simulatedTime = DGKBFanoutTestStartTime;
+    for (DGKBSimulatedCentral *central in centrals)
+    {
+        [fanout addCentral:central];
+    }
+
+    uint32_t index = 0;
+    NSUInteger ticks = (NSUInteger)(DGKBFanoutTestDuration / DGKBFanoutTestConnectionInterval + 0.5);
+    for (NSUInteger tick = 0; tick < ticks; tick++)
+    {
+        NSTimeInterval now = DGKBFanoutTestStartTime + tick * DGKBFanoutTestConnectionInterval;
+        fanout.simulatedTime = now;
+        for (DGKBSimulatedCentral *central in centrals)
+        {
+            [central receiveFramesAtTime:now];
+            for (NSData *ack in [central.ackLink packetsArrivingBy:now])
+            {
+                [fanout processAck:ack
+                       fromCentral:central];
+            }
+        }
+        for (NSUInteger queued = 0; queued < DGKBFanoutTestPayloadsPerInterval; queued++)
+        {
+            [fanout enqueuePayload:[DGKBSimulatedCentral payloadWithIndex:index++
+                                                                   atTime:now]];
+        }
+        __block NSUInteger sent = 0;
+        [fanout serviceWithBlock:^BOOL(NSData *frame, CBCentral *central) {
+            if (sent >= DGKBFanoutTestQueueCapacity) return NO;
+            sent++;
+            [((DGKBSimulatedCentral *)central).dataLink sendPacket:frame
+                                                            atTime:now];
+            return YES;
+        }];
+    }
+    return centrals;
+}
+
+/**
+ - For each number of centrals, run the fast centrals on their own, then again alongside the slow one
+ - Every fast central must be delivered at least as much as in the baseline, within a couple of intervals of everything queued
+ - Its 99th percentile and worst latency may grow by at most one connection interval
+ - Report each fast central's throughput and tail latency against the baseline
+ */
+- (void)assertFastCentralsUnaffectedBySlowCentral:(DGKBSlowCentralType)slow
+{
+    NSUInteger produced = (NSUInteger)(DGKBFanoutTestDuration / DGKBFanoutTestConnectionInterval + 0.5) * DGKBFanoutTestPayloadsPerInterval;
+    NSUInteger inTransit = 2 * DGKBFanoutTestPayloadsPerInterval;
+    NSMutableString *report = [NSMutableString stringWithFormat:@"\n%@ slow central\n%8s %10s %10s %10s %10s %10s %10s\n",
+                               slow == DGKBSlowCentralNeverAcks ? @"Never acknowledging" : @"Late acknowledging",
+                               "centrals", "fast B/s", "p99 ms", "max ms", "base p99", "base max", "slow got"];
+    for (NSUInteger count = 2; count <= DGKBFanoutTestMaxCentrals; count++)
+    {
+        NSArray *baseline = [self serveFastCentrals:count - 1
+                                        slowCentral:DGKBSlowCentralNone];
+        NSArray *centrals = [self serveFastCentrals:count - 1
+                                        slowCentral:slow];
+        DGKBSimulatedCentral *slowCentral = [centrals lastObject];
+
+        NSUInteger baseDelivered = NSUIntegerMax;
+        NSTimeInterval baseP99 = 0;
+        NSTimeInterval baseMax = 0;
+        for (DGKBSimulatedCentral *central in baseline)
+        {
+            baseDelivered = MIN(baseDelivered, central.deliveredCount);
+            baseP99 = MAX(baseP99, [central latencyPercentile:99]);
+            baseMax = MAX(baseMax, [central latencyPercentile:100]);
+        }
+        XCTAssertTrue(baseDelivered + inTransit >= produced, @"%lu fast centrals on their own should keep up", (unsigned long)(count - 1));
+
+        NSUInteger fastDelivered = NSUIntegerMax;
+        NSTimeInterval fastP99 = 0;
+        NSTimeInterval fastMax = 0;
+        for (NSUInteger index = 0; index + 1 < centrals.count; index++)
+        {
+            DGKBSimulatedCentral *central = centrals[index];
+            NSTimeInterval p99 = [central latencyPercentile:99];
+            NSTimeInterval worst = [central latencyPercentile:100];
+            XCTAssertTrue(central.deliveredCount >= baseDelivered, @"%@ of %lu should be delivered %lu payloads, not %lu",
+                          central.name, (unsigned long)count, (unsigned long)baseDelivered, (unsigned long)central.deliveredCount);
+            XCTAssertTrue(p99 <= baseP99 + DGKBFanoutTestConnectionInterval, @"%@ of %lu: p99 %.0f ms against %.0f ms on its own",
+                          central.name, (unsigned long)count, p99 * 1000.0, baseP99 * 1000.0);
+            XCTAssertTrue(worst <= baseMax + DGKBFanoutTestConnectionInterval, @"%@ of %lu: worst %.0f ms against %.0f ms on its own",
+                          central.name, (unsigned long)count, worst * 1000.0, baseMax * 1000.0);
+            fastDelivered = MIN(fastDelivered, central.deliveredCount);
+            fastP99 = MAX(fastP99, p99);
+            fastMax = MAX(fastMax, worst);
+        }
+        XCTAssertTrue(slowCentral.deliveredCount < fastDelivered, @"The slow central should have fallen behind");
+
+        [report appendFormat:@"%8lu %10.0f %10.1f %10.1f %10.1f %10.1f %10lu\n",
+         (unsigned long)count,
+         fastDelivered * DGKBSimulatedPayloadLength / DGKBFanoutTestDuration,
+         fastP99 * 1000.0,
+         fastMax * 1000.0,
+         baseP99 * 1000.0,
+         baseMax * 1000.0,
+         (unsigned long)slowCentral.deliveredCount];
+    }
+    NSLog(@"%@", report);
+}
+
+#pragma mark - Tests
+
+/**
+ - A central that never acknowledges fills its own window and then only gets resends; the others carry on
+ */
+- (void)testNeverAcknowledgingCentralDoesNotHoldBackOthers
+{
+    [self assertFastCentralsUnaffectedBySlowCentral:DGKBSlowCentralNeverAcks];
+}
+
+/**
+ - A central whose acknowledgements arrive late keeps timing out and resending, and opens its window in bursts;
+   the deficit round robin must keep those bursts from crowding out the others
+ */
+- (void)testLateAcknowledgingCentralDoesNotHoldBackOthers
+{
+    [self assertFastCentralsUnaffectedBySlowCentral:DGKBSlowCentralAcksLate];
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,68 @@
+//
+//  DGKBLossyLink.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ @interface DGKBLossyLink
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Simulated lossy link
+
+ A one way, in-memory link on a simulated clock. Each packet is either lost or arrives a fixed
+ latency after it was sent, in the order it was sent. Losses come from a seeded generator, so a
+ run with the same seed loses the same packets.
+ */
+@interface DGKBLossyLink : NSObject
+
+/// The share (0 to 1) of packets that are lost
+@property (nonatomic, readonly) double lossRate;
+
+/// How long a packet takes to arrive
+@property (nonatomic, readonly) NSTimeInterval latency;
+
+/// The number of packets sent
+@property (nonatomic, readonly) NSUInteger sentCount;
+
+/// The number of packets lost
+@property (nonatomic, readonly) NSUInteger lostCount;
+
+/**
+ @brief Initialise a link
+
+ @param lossRate The share (0 to 1) of packets to lose
+ @param latency How long a packet takes to arrive
+ @param seed Seeds the generator that picks which packets are lost (0 is treated as 1)
+ @return The link
+ */
+- (id)initWithLossRate:(double)lossRate
+               latency:(NSTimeInterval)latency
+                  seed:(uint32_t)seed;
+
+/**
+ @brief Send a packet
+
+ @param packet The packet
+ @param now The simulated time
+ */
+- (void)sendPacket:(NSData *)packet
+            atTime:(NSTimeInterval)now;
+
+/**
+ @brief Take the packets that have arrived
+
+ @param now The simulated time
+ @return The packets that have arrived by now and not been taken yet, in the order they were sent
+ */
+- (NSArray *)packetsArrivingBy:(NSTimeInterval)now;
+
+@end
+
+/** @} */
@@ -0,0 +1,98 @@
+//
+//  DGKBLossyLink.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBLossyLink.h"
+
+/**
+ @extends DGKBLossyLink
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Simulated lossy link extension
+
+ Internal functionality for the simulated link. Private extensions to DGKBLossyLink @see DGKBLossyLink
+ */
+@interface DGKBLossyLink ()
+
+@property (nonatomic, assign) uint32_t state;           ///< The loss generator's state
+@property (nonatomic, strong) NSMutableArray *packets;  ///< Packets in transit, oldest first
+@property (nonatomic, strong) NSMutableArray *arrivals; ///< When each packet in transit arrives
+
+/**
+ @brief Draw from the loss generator
+ @return A number from 0 up to, but not including, 1
+ */
+- (double)nextRandom;
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBLossyLink
+ @addtogroup Tests
+ @{
+ */
+@implementation DGKBLossyLink
+
+- (id)initWithLossRate:(double)lossRate
+               latency:(NSTimeInterval)latency
+                  seed:(uint32_t)seed
+{
+    self = [super init];
+    if (self)
+    {
+        _lossRate = lossRate;
+        _latency = latency;
+        _state = seed ? seed : 1;
+        _packets = [NSMutableArray array];
+        _arrivals = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)sendPacket:(NSData *)packet
+            atTime:(NSTimeInterval)now
+{
+    _sentCount++;
+    if ([self nextRandom] < _lossRate)
+    {
+        _lostCount++;
+        return;
+    }
+    [_packets addObject:packet];
+    [_arrivals addObject:@(now + _latency)];
+}
+
+- (NSArray *)packetsArrivingBy:(NSTimeInterval)now
+{
+    NSUInteger count = 0;
+    while (count < _arrivals.count && [_arrivals[count] doubleValue] <= now) count++;
+
+    NSRange range = NSMakeRange(0, count);
+    NSArray *arrived = [_packets subarrayWithRange:range];
+    [_packets removeObjectsInRange:range];
+    [_arrivals removeObjectsInRange:range];
+    return arrived;
+}
+
+/**
+ - A 32 bit xorshift generator: cheap, and the same on every platform
+ */
+- (double)nextRandom
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state / 4294967296.0;
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,92 @@
+//
+//  DGKBSimulatedCentral.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import <CoreBluetooth/CoreBluetooth.h>
+#import "BlueCommon.h"
+
+@class DGKBLossyLink;
+
+/**
+ @def DGKBSimulatedPayloadLength
+ @brief Defines the payload length; a full sample frame, carrying its index and when it was queued
+ */
+#define DGKBSimulatedPayloadLength SAMPLEFRAMELENGTH
+
+/**
+ @interface DGKBSimulatedCentral
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Simulated subscribed central
+
+ Stands in for a central that has subscribed to the broadcaster's notifications. Frames reach it
+ over a data link one connection interval after they are sent; it acknowledges them the way the
+ listener does, over an ack link with its own latency, so a slow central is one whose
+ acknowledgements arrive late or never. It keeps how long each payload took from being queued to
+ being delivered.
+ */
+@interface DGKBSimulatedCentral : CBCentral
+
+/// The central's name, for reports
+@property (nonatomic, readonly) NSString *name;
+
+/// The link that carries notifications to the central
+@property (nonatomic, readonly) DGKBLossyLink *dataLink;
+
+/// The link that carries acknowledgements back
+@property (nonatomic, readonly) DGKBLossyLink *ackLink;
+
+/// Whether the central acknowledges anything
+@property (nonatomic, readonly) BOOL acknowledges;
+
+/// The number of payloads delivered
+@property (nonatomic, readonly) NSUInteger deliveredCount;
+
+/**
+ @brief Initialise a central
+
+ @param name The central's name
+ @param dataLatency How long a notification takes to reach the central
+ @param ackLatency How long an acknowledgement takes to get back
+ @param acknowledges NO for a central that never acknowledges anything
+ @return The central
+ */
+- (id)initWithName:(NSString *)name
+       dataLatency:(NSTimeInterval)dataLatency
+        ackLatency:(NSTimeInterval)ackLatency
+      acknowledges:(BOOL)acknowledges;
+
+/**
+ @brief Make a payload that carries its index and when it was queued
+
+ @param index The index
+ @param now The simulated time
+ @return The payload, DGKBSimulatedPayloadLength bytes long
+ */
++ (NSData *)payloadWithIndex:(uint32_t)index
+                      atTime:(NSTimeInterval)now;
+
+/**
+ @brief Take the notifications that have arrived and acknowledge them
+
+ @param now The simulated time
+ */
+- (void)receiveFramesAtTime:(NSTimeInterval)now;
+
+/**
+ @brief Get a percentile of the delivery latency
+
+ @param percentile The percentile, from 0 to 100
+ @return The latency in seconds, or 0 if nothing has been delivered
+ */
+- (NSTimeInterval)latencyPercentile:(double)percentile;
+
+@end
+
+/** @} */
@@ -0,0 +1,119 @@
+//
+//  DGKBSimulatedCentral.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSimulatedCentral.h"
+#import "DGKBLossyLink.h"
+#import "DGKBReceiveWindow.h"
+
+/**
+ @extends DGKBSimulatedCentral
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Simulated subscribed central extension
+
+ Internal functionality for the simulated central. Private extensions to DGKBSimulatedCentral @see DGKBSimulatedCentral
+ */
+@interface DGKBSimulatedCentral ()
+
+@property (nonatomic, strong) DGKBReceiveWindow *receiver;  ///< The central's receive window
+@property (nonatomic, assign) NSTimeInterval ackDue;        ///< When the oldest unacknowledged frame must be acknowledged
+@property (nonatomic, strong) NSMutableArray *latencies;    ///< Seconds from queued to delivered, for each payload
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBSimulatedCentral
+ @addtogroup Tests
+ @{
+ */
+@implementation DGKBSimulatedCentral
+
+- (id)initWithName:(NSString *)name
+       dataLatency:(NSTimeInterval)dataLatency
+        ackLatency:(NSTimeInterval)ackLatency
+      acknowledges:(BOOL)acknowledges
+{
+    self = [super init];
+    if (self)
+    {
+        _name = name;
+        _acknowledges = acknowledges;
+        _dataLink = [[DGKBLossyLink alloc] initWithLossRate:0.0
+                                                    latency:dataLatency
+                                                       seed:1];
+        _ackLink = [[DGKBLossyLink alloc] initWithLossRate:0.0
+                                                   latency:ackLatency
+                                                      seed:1];
+        _receiver = [[DGKBReceiveWindow alloc] initWithWindowSize:ACKWINDOWSIZE];
+        _latencies = [NSMutableArray array];
+    }
+    return self;
+}
+
+/**
+ - No UUID, so the fan-out scheduler keys each simulated central by its address
+ */
+- (CFUUIDRef)UUID
+{
+    return NULL;
+}
+
++ (NSData *)payloadWithIndex:(uint32_t)index
+                      atTime:(NSTimeInterval)now
+{
+    uint8_t bytes[DGKBSimulatedPayloadLength] = {0};
+    memcpy(bytes, &index, sizeof(index));
+    memcpy(bytes + sizeof(index), &now, sizeof(now));
+    return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+}
+
+/**
+ - Deliver what the receive window releases and keep each payload's latency
+ - Acknowledge as the listener does: at half a window, or ACKINTERVAL after the first unacknowledged frame
+ */
+- (void)receiveFramesAtTime:(NSTimeInterval)now
+{
+    for (NSData *frame in [_dataLink packetsArrivingBy:now])
+    {
+        if (_receiver.unacknowledgedCount == 0) _ackDue = now + ACKINTERVAL;
+        for (NSData *payload in [_receiver payloadsForFrame:frame])
+        {
+            NSTimeInterval queuedAt = 0;
+            [payload getBytes:&queuedAt range:NSMakeRange(sizeof(uint32_t), sizeof(queuedAt))];
+            [_latencies addObject:@(now - queuedAt)];
+            _deliveredCount++;
+        }
+    }
+    if (_acknowledges && _receiver.unacknowledgedCount > 0 &&
+        (_receiver.unacknowledgedCount >= _receiver.windowSize / 2 || now >= _ackDue))
+    {
+        [_ackLink sendPacket:[_receiver ackPacket]
+                      atTime:now];
+    }
+}
+
+/**
+ - Nearest rank: the smallest latency that at least that share of payloads were delivered within
+ */
+- (NSTimeInterval)latencyPercentile:(double)percentile
+{
+    if (_latencies.count == 0) return 0;
+
+    NSArray *sorted = [_latencies sortedArrayUsingSelector:@selector(compare:)];
+    NSUInteger rank = (NSUInteger)ceil(percentile / 100.0 * sorted.count);
+    rank = MIN(MAX(rank, 1), sorted.count);
+    return [sorted[rank - 1] doubleValue];
+}
+
+@end
+
+/** @} */
@@ -0,0 +1,30 @@
+//
+//  DGKBSimulatedFanoutScheduler.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBFanoutScheduler.h"
+
+/**
+ @interface DGKBSimulatedFanoutScheduler
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Fan-out scheduler on a simulated clock
+
+ Gives each central a send window on a simulated clock, so a test decides when retransmissions
+ fall due. Setting simulatedTime sets it on every window the scheduler has made.
+ @see DGKBSimulatedSendWindow
+ */
+@interface DGKBSimulatedFanoutScheduler : DGKBFanoutScheduler
+
+/// The time the send windows read from their clocks
+@property (nonatomic, assign) NSTimeInterval simulatedTime;
+
+@end
+
+/** @} */
@@ -0,0 +1,63 @@
+//
+//  DGKBSimulatedFanoutScheduler.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSimulatedFanoutScheduler.h"
+#import "DGKBSimulatedSendWindow.h"
+
+/**
+ @extends DGKBSimulatedFanoutScheduler
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Fan-out scheduler on a simulated clock extension
+
+ Internal functionality for the simulated scheduler. Private extensions to DGKBSimulatedFanoutScheduler @see DGKBSimulatedFanoutScheduler
+ */
+@interface DGKBSimulatedFanoutScheduler ()
+
+@property (nonatomic, strong) NSHashTable *windows;     ///< The windows the scheduler has made, held weakly
+
+@end
+
+/** @} */
+
+/**
+ @implements DGKBSimulatedFanoutScheduler
+ @addtogroup Tests
+ @{
+ */
+@implementation DGKBSimulatedFanoutScheduler
+
+- (void)setSimulatedTime:(NSTimeInterval)simulatedTime
+{
+    _simulatedTime = simulatedTime;
+    for (DGKBSimulatedSendWindow *window in _windows)
+    {
+        window.simulatedTime = simulatedTime;
+    }
+}
+
+/**
+ - Start the new window at the current simulated time, and keep hold of it to move its clock on later
+ */
+- (DGKBSendWindow *)sendWindowWithSize:(NSUInteger)windowSize
+                     retransmitTimeout:(NSTimeInterval)seconds
+{
+    if (!_windows) _windows = [NSHashTable weakObjectsHashTable];
+
+    DGKBSimulatedSendWindow *window = [[DGKBSimulatedSendWindow alloc] initWithWindowSize:windowSize
+                                                                        retransmitTimeout:seconds];
+    window.simulatedTime = _simulatedTime;
+    [_windows addObject:window];
+    return window;
+}
+
+@end
+
+/** @} */
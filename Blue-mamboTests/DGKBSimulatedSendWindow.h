@@ -0,0 +1,30 @@
+//
+//  DGKBSimulatedSendWindow.h
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSendWindow.h"
+
+/**
+ @interface DGKBSimulatedSendWindow
+ @addtogroup Tests
+ @{
+ */
+/**
+ @brief Send window on a simulated clock
+
+ Times its frames with simulatedTime instead of the system uptime, so a test decides when
+ retransmissions fall due. The send window treats a send time of 0 as never sent, so the
+ simulated clock should start after 0.
+ */
+@interface DGKBSimulatedSendWindow : DGKBSendWindow
+
+/// The time the window reads from its clock
+@property (nonatomic, assign) NSTimeInterval simulatedTime;
+
+@end
+
+/** @} */
@@ -0,0 +1,25 @@
+//
+//  DGKBSimulatedSendWindow.m
+//  Blue-mambo
+//
+//  Created by agent on 19/10/26.
+//  Copyright (c) 2026 DGKB. All rights reserved.
+//
+
+#import "DGKBSimulatedSendWindow.h"
+
+/**
+ @implements DGKBSimulatedSendWindow
+ @addtogroup Tests
+ @{
+ */
+@implementation DGKBSimulatedSendWindow
+
+- (NSTimeInterval)currentTime
+{
+    return _simulatedTime;
+}
+
+@end
+
+/** @} */